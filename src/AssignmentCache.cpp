@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AssignmentCache.h"
+
+AssignmentCache::AssignmentCache(const_ptr<InputData> const& inputData, size_t maxBytes)
+{
+    // Rough estimate of the memory needed by one entry: the scheduling and assignment data plus the bookkeeping
+    // overhead of the hash map node, the shared pointer and the insertion order queue.
+    //
+    size_t entryBytes = sizeof(Scheduling) + inputData->choice_count() * sizeof(int)
+            + sizeof(Assignment) + inputData->chooser_count() * (sizeof(vector<int>) + inputData->slot_count() * sizeof(int))
+            + 96;
+
+    _maxEntriesPerShard = std::max((size_t)1, maxBytes / entryBytes / SHARD_COUNT);
+
+    for(int i = 0; i < SHARD_COUNT; i++)
+    {
+        _shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+AssignmentCache::Shard& AssignmentCache::shard_of(Scheduling const& scheduling) const
+{
+    return *_shards[shard_index(scheduling)];
+}
+
+int AssignmentCache::shard_index(Scheduling const& scheduling)
+{
+    return std::hash<Scheduling>()(scheduling) % SHARD_COUNT;
+}
+
+bool AssignmentCache::try_get(Scheduling const& scheduling, const_ptr<Assignment const>& assignment)
+{
+    Shard& shard = shard_of(scheduling);
+    std::shared_lock lock(shard.mutex);
+
+    auto it = shard.entries.find(scheduling);
+    if(it == shard.entries.end())
+    {
+        _misses++;
+        return false;
+    }
+
+    assignment = it->second;
+    _hits++;
+    return true;
+}
+
+void AssignmentCache::insert(Scheduling const& scheduling, const_ptr<Assignment const> assignment)
+{
+    Shard& shard = shard_of(scheduling);
+    std::unique_lock lock(shard.mutex);
+
+    auto inserted = shard.entries.insert({scheduling, std::move(assignment)});
+    if(!inserted.second) return;
+
+    // References to the keys of an unordered map stay valid until the element is erased, so the queue can point
+    // directly to them.
+    //
+    shard.insertionOrder.push_back(&inserted.first->first);
+
+    while(shard.insertionOrder.size() > _maxEntriesPerShard)
+    {
+        shard.entries.erase(*shard.insertionOrder.front());
+        shard.insertionOrder.pop_front();
+    }
+}
+
+size_t AssignmentCache::capacity() const
+{
+    return _maxEntriesPerShard * SHARD_COUNT;
+}
+
+long AssignmentCache::hits() const
+{
+    return _hits;
+}
+
+long AssignmentCache::misses() const
+{
+    return _misses;
+}
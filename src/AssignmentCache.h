@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "InputData.h"
+#include "Scheduling.h"
+#include "Assignment.h"
+
+#include <shared_mutex>
+#include <deque>
+
+/**
+ * A bounded, thread-safe cache mapping schedulings to their optimal assignments (or nullptr if there is no valid
+ * assignment for a scheduling). A single instance can be shared by all solver threads.
+ *
+ * The cache is split into several shards, each guarded by its own lock, so concurrent lookups of different schedulings
+ * rarely contend. If a shard is full, its oldest entry is evicted.
+ */
+class AssignmentCache
+{
+public:
+    /**
+     * The number of shards. Each shard holds an equal share of the capacity and evicts its own oldest entries.
+     */
+    static const int SHARD_COUNT = 16;
+
+private:
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        map<Scheduling, const_ptr<Assignment const>> entries;
+        std::deque<Scheduling const*> insertionOrder;
+    };
+
+    size_t _maxEntriesPerShard;
+    vector<unique_ptr<Shard>> _shards;
+
+    atomic<long> _hits = 0;
+    atomic<long> _misses = 0;
+
+    /**
+     * Returns the shard responsible for the given scheduling.
+     */
+    Shard& shard_of(Scheduling const& scheduling) const;
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param inputData The input data of the cached schedulings; used to estimate the memory needed per entry.
+     * @param maxBytes The (approximate) maximum amount of memory used by the cache entries.
+     */
+    AssignmentCache(const_ptr<InputData> const& inputData, size_t maxBytes);
+
+    /**
+     * Looks up the assignment of the given scheduling. Returns false if the scheduling is not in the cache.
+     */
+    bool try_get(Scheduling const& scheduling, const_ptr<Assignment const>& assignment);
+
+    /**
+     * Inserts the assignment of the given scheduling into the cache.
+     */
+    void insert(Scheduling const& scheduling, const_ptr<Assignment const> assignment);
+
+    /**
+     * Returns the index of the shard responsible for the given scheduling.
+     */
+    [[nodiscard]] static int shard_index(Scheduling const& scheduling);
+
+    /**
+     * Returns the maximum number of entries this cache can hold.
+     */
+    [[nodiscard]] size_t capacity() const;
+
+    /**
+     * Returns the number of lookups that found the scheduling in the cache.
+     */
+    [[nodiscard]] long hits() const;
+
+    /**
+     * Returns the number of lookups that did not find the scheduling in the cache.
+     */
+    [[nodiscard]] long misses() const;
+};
@@ -22,12 +22,22 @@
 #include <ortools/linear_solver/linear_solver.h>
 
 #include "Constraints.h"
+#include "MaxFlow.h"
 
 #include <utility>
+#include <numeric>
+#include <thread>
 
-set<pair<int, int>> AssignmentSolver::get_blocked_constraint_edges(shared_ptr<Scheduling const> const& scheduling)
+void AssignmentSolver::set_time_limit(MipSolver& solver) const
 {
-    set<pair<int, int>> blockedEdges;
+    solver.set_time_limit(_options->assignment_timeout_seconds() * 1000L,
+                          _cancellation.valid() ? optional<datetime>(_deadline) : std::nullopt);
+}
+
+vector<bool> AssignmentSolver::get_blocked_constraint_edges(shared_ptr<Scheduling const> const& scheduling)
+{
+    int choiceCount = _inputData->choice_count();
+    vector<bool> blockedEdges(_inputData->chooser_count() * choiceCount, false);
 
     for(Constraint constraint : _staticData->constraints)
     {
@@ -36,25 +46,18 @@ set<pair<int, int>> AssignmentSolver::get_blocked_constraint_edges(shared_ptr<Sc
             case ChooserIsInChoice:
             {
                 int s = scheduling->slot_of(constraint.right());
-                int from = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_chooser(constraint.left(), s));
 
-                for(int w = 0; w < _inputData->choice_count(); w++)
+                for(int w = 0; w < choiceCount; w++)
                 {
                     if(constraint.right() == w || scheduling->slot_of(w) != s) continue;
 
-                    int to = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_choice(w));
-                    blockedEdges.insert(std::make_pair(from, to));
+                    blockedEdges[constraint.left() * choiceCount + w] = true;
                 }
                 break;
             }
             case ChooserIsNotInChoice:
             {
-                for(int s = 0; s < _inputData->slot_count(); s++)
-                {
-                    int from = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_chooser(constraint.left(), s));
-                    int to = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_choice(constraint.right()));
-                    blockedEdges.insert(std::make_pair(from, to));
-                }
+                blockedEdges[constraint.left() * choiceCount + constraint.right()] = true;
                 break;
             }
             case ChoicesHaveSameChoosers: // This is handled in create_edge_groups with Constraints::get_dependent_choices.
@@ -69,29 +72,30 @@ set<pair<int, int>> AssignmentSolver::get_blocked_constraint_edges(shared_ptr<Sc
         }
     }
 
+    for(auto blocked : _staticData->blockedEdges)
+    {
+        blockedEdges[blocked.first * choiceCount + blocked.second] = true;
+    }
+
     return blockedEdges;
 }
 
-void AssignmentSolver::create_edge_groups(const_ptr<Scheduling> const& scheduling, MipFlow<flowid, flowid>& flow)
+void AssignmentSolver::create_edge_groups(MipFlow& flow, vector<int> const& chooserEdges)
 {
-    // Edge groups for ChoosersHaveSameChoices
+    int choiceCount = _inputData->choice_count();
+
+    // Edge groups for ChoosersHaveSameChoices. There is only one edge between a chooser and a choice (the one in the
+    // slot of the choice), so one group per choice suffices.
     //
     for(Constraint constraint : _inputData->assignment_constraints())
     {
         if(constraint.type() != ChoosersHaveSameChoices) continue;
 
-        for (int s = 0; s < _inputData->slot_count(); s++)
+        for (int w = 0; w < choiceCount; w++)
         {
-            for (int w = 0; w < _inputData->choice_count(); w++)
-            {
-                int from1 = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_chooser(constraint.left(), s));
-                int to1 = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_choice(w));
-                int from2 = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_chooser(constraint.right(), s));
-                int to2 = _staticData->baseFlow.nodes().at(MipFlowStaticData::node_choice(w));
-
-                vector<flowid> edgeGroup { MipFlowStaticData::edge_id(from1, to1), MipFlowStaticData::edge_id(from2, to2) };
-                flow.create_edge_group_or_block_edges(edgeGroup.begin(), edgeGroup.end());
-            }
+            flow.create_edge_group_or_block_edges({
+                chooserEdges[constraint.left() * choiceCount + w],
+                chooserEdges[constraint.right() * choiceCount + w]});
         }
     }
 
@@ -105,37 +109,44 @@ void AssignmentSolver::create_edge_groups(const_ptr<Scheduling> const& schedulin
 
         for(int p = 0; p < _inputData->chooser_count(); p++)
         {
-            vector<flowid> edgeGroup;
+            vector<int> edgeGroup;
             for(int w : group)
             {
-                int s = scheduling->slot_of(w);
-                int from = flow.nodes().at(MipFlowStaticData::node_chooser(p, s));
-                int to = flow.nodes().at(MipFlowStaticData::node_choice(w));
-                edgeGroup.push_back(MipFlowStaticData::edge_id(from, to));
+                edgeGroup.push_back(chooserEdges[p * choiceCount + w]);
             }
 
-            flow.create_edge_group_or_block_edges(edgeGroup.begin(), edgeGroup.end());
+            flow.create_edge_group_or_block_edges(edgeGroup);
         }
     }
 }
 
-const_ptr<Assignment> AssignmentSolver::solve_with_limit(const_ptr<Scheduling> const& scheduling,
-                                                                int preferenceLimit,
-                                                                op::MPSolver& solver)
+AssignmentSolver::FlowTemplate& AssignmentSolver::flow_template(const_ptr<Scheduling const> const& scheduling)
 {
-    MipFlow<flowid, flowid> flow(_staticData->baseFlow);
+    if(_flowTemplate != nullptr && *_flowTemplate->scheduling == *scheduling)
+    {
+        return *_flowTemplate;
+    }
+
+    _flowTemplate = std::make_unique<FlowTemplate>();
+    _flowTemplate->scheduling = scheduling;
+    _flowTemplate->flow = _staticData->baseFlow;
+
+    MipFlow& flow = _flowTemplate->flow;
+    vector<int>& edgePreferences = _flowTemplate->edgePreferences;
+    vector<int>& chooserEdges = _flowTemplate->chooserEdges;
+    int choiceCount = _inputData->choice_count();
 
     for(int p = 0; p < _inputData->chooser_count(); p++)
     {
         for(int s = 0; s < _inputData->slot_count(); s++)
         {
-            flow.set_supply(flow.nodes().at(MipFlowStaticData::node_chooser(p, s)), 1);
+            flow.set_supply(_staticData->node_chooser(p, s), 1);
         }
     }
 
-    for(int w = 0; w < _inputData->choice_count(); w++)
+    for(int w = 0; w < choiceCount; w++)
     {
-        flow.set_supply(flow.nodes().at(MipFlowStaticData::node_choice(w)), -_inputData->choice(w).min);
+        flow.set_supply(_staticData->node_choice(w), -_inputData->choice(w).min);
     }
 
     for(int s = 0; s < _inputData->slot_count(); s++)
@@ -143,173 +154,776 @@ const_ptr<Assignment> AssignmentSolver::solve_with_limit(const_ptr<Scheduling> c
         // Count the number of choosers that will already be absorbed by the choice nodes.
         //
         int coveredChoosers = 0;
-        for(int w = 0; w < _inputData->choice_count(); w++)
+        for(int w = 0; w < choiceCount; w++)
         {
             if(scheduling->slot_of(w) != s) continue;
             coveredChoosers += _inputData->choice(w).min;
         }
 
         flow.set_supply(
-                flow.nodes().at(MipFlowStaticData::node_slot(s)),
+                _staticData->node_slot(s),
                 -(_inputData->chooser_count() - coveredChoosers));
     }
 
-    vector<int> edgesCap;
-    vector<long> edgesCost;
-    map<pair<int, int>, int> edgesIdx;
-    int nextEdgeIdx = 0;
+    auto blockedEdges = get_blocked_constraint_edges(scheduling);
+
+    edgePreferences.clear();
+    chooserEdges.assign(_inputData->chooser_count() * choiceCount, -1);
 
     for(int p = 0; p < _inputData->chooser_count(); p++)
     {
-        for(int s = 0; s < _inputData->slot_count(); s++)
+        for(int w = 0; w < choiceCount; w++)
         {
-            for(int w = 0; w < _inputData->choice_count(); w++)
-            {
-                if(scheduling->slot_of(w) != s || _inputData->chooser(p).preferences[w] > preferenceLimit)
-                    continue;
+            if(blockedEdges[p * choiceCount + w]) continue;
+
+            int pref = _inputData->chooser(p).preferences[w];
+            chooserEdges[p * choiceCount + w] = flow.add_edge(
+                    _staticData->node_chooser(p, scheduling->slot_of(w)),
+                    _staticData->node_choice(w),
+                    1,
+                    _preferenceCosts[pref]);
+            edgePreferences.push_back(pref);
+        }
+    }
+
+    for(int w = 0; w < choiceCount; w++)
+    {
+        flow.add_edge(
+                _staticData->node_choice(w),
+                _staticData->node_slot(scheduling->slot_of(w)),
+                _inputData->choice(w).max - _inputData->choice(w).min,
+                0);
+        edgePreferences.push_back(-1);
+    }
+
+    // Create edge groups
+    //
+    create_edge_groups(flow, chooserEdges);
+
+    // All chooser-choice edges start out enabled; a preference limit then only enables a prefix of the edges sorted
+    // by preference.
+    //
+    auto& limitedEdges = _flowTemplate->limitedEdges;
+    for(int edge = 0; edge < edgePreferences.size(); edge++)
+    {
+        if(edgePreferences[edge] >= 0) limitedEdges.push_back(edge);
+    }
+
+    std::stable_sort(limitedEdges.begin(), limitedEdges.end(), [&](int a, int b)
+    {
+        return edgePreferences[a] < edgePreferences[b];
+    });
+
+    _flowTemplate->enabledEdges = limitedEdges.size();
 
-                edgesCap.push_back(1);
-                edgesCost.push_back(
-                        (long)pow(_inputData->chooser(p).preferences[w] + 1.0, _options->preference_exponent()));
+    return *_flowTemplate;
+}
 
-                edgesIdx[std::make_pair(
-                        flow.nodes().at(MipFlowStaticData::node_chooser(p, s)),
-                        flow.nodes().at(MipFlowStaticData::node_choice(w)))]
-                        = nextEdgeIdx++;
+void AssignmentSolver::set_preference_limit(FlowTemplate& flowTemplate, int preferenceLimit)
+{
+    auto const& limitedEdges = flowTemplate.limitedEdges;
+    int enabledEdges = std::upper_bound(
+            limitedEdges.begin(),
+            limitedEdges.end(),
+            preferenceLimit,
+            [&](int limit, int edge) { return limit < flowTemplate.edgePreferences[edge]; }) - limitedEdges.begin();
+
+    // Only the edges between the old and the new end of the prefix change.
+    //
+    int first = std::min(enabledEdges, flowTemplate.enabledEdges);
+    int last = std::max(enabledEdges, flowTemplate.enabledEdges);
+    for(int i = first; i < last; i++)
+    {
+        flowTemplate.flow.set_edge_max(limitedEdges[i], i < enabledEdges ? 1 : 0);
+    }
+
+    flowTemplate.enabledEdges = enabledEdges;
+}
+
+const_ptr<Assignment> AssignmentSolver::solve_with_limit(FlowTemplate& flowTemplate, int preferenceLimit)
+{
+    // Edges exceeding the preference limit are not removed but get a maximum flow of zero. Note that this also
+    // blocks all edge groups containing such an edge, just like removing the edge would.
+    //
+    set_preference_limit(flowTemplate, preferenceLimit);
+
+    MipFlow& flow = flowTemplate.flow;
+    if(!flow.solve(*_solver, _options->assignment_backend(), _cancellation))
+    {
+        _interrupted = _interrupted || flow.interrupted();
+        return nullptr;
+    }
+
+    // Now we have to extract the assignment solution from the min cost flow solution
+    //
+    int choiceCount = _inputData->choice_count();
+    vector<vector<int>> data(_inputData->chooser_count(), vector<int>(_inputData->slot_count(), -1));
+    for(int p = 0; p < _inputData->chooser_count(); p++)
+    {
+        for(int w = 0; w < choiceCount; w++)
+        {
+            int edge = flowTemplate.chooserEdges[p * choiceCount + w];
+
+            if(edge >= 0 && flow.solution_value_at(edge) == 1)
+            {
+                data[p][flowTemplate.scheduling->slot_of(w)] = w;
             }
         }
     }
 
-    for(int w = 0; w < _inputData->choice_count(); w++)
+    _lpCount++;
+    return std::make_shared<Assignment const>(_inputData, data);
+}
+
+optional<int> AssignmentSolver::find_bottleneck(FlowTemplate& flowTemplate)
+{
+    auto costs = lexicographic_costs(_inputData->chooser_count() * _inputData->slot_count());
+    if(costs.empty())
     {
-        for(int s = 0; s < _inputData->slot_count(); s++)
+        return std::nullopt;
+    }
+
+    MipFlow& flow = flowTemplate.flow;
+    vector<int> const& edgePreferences = flowTemplate.edgePreferences;
+
+    set_preference_limit(flowTemplate, _inputData->max_preference());
+    for(int edge : flowTemplate.limitedEdges)
+    {
+        flow.set_edge_cost(edge, costs[edgePreferences[edge]]);
+    }
+
+    bool solved = flow.solve(*_solver, _options->assignment_backend(), _cancellation);
+    _interrupted = _interrupted || flow.interrupted();
+    _lpCount++;
+
+    int bottleneck = 0;
+    for(int edge = 0; solved && edge < edgePreferences.size(); edge++)
+    {
+        if(edgePreferences[edge] < 0 || flow.solution_value_at(edge) == 0) continue;
+        bottleneck = std::max(bottleneck, edgePreferences[edge]);
+    }
+
+    for(int edge : flowTemplate.limitedEdges)
+    {
+        flow.set_edge_cost(edge, _preferenceCosts[edgePreferences[edge]]);
+    }
+
+    return solved ? bottleneck : _inputData->max_preference();
+}
+
+vector<long> AssignmentSolver::lexicographic_costs(int units) const
+{
+    // All costs together have to be exactly representable as doubles, so MIP solvers can handle them, too.
+    //
+    const long maxTotalCost = 1L << 50;
+
+    vector<long> costs(_inputData->max_preference() + 1, 1);
+    long levelCost = 1;
+
+    // The preference levels below the preference bound can never be the bottleneck, so they all get the lowest cost.
+    //
+    for(int level : _inputData->preference_levels())
+    {
+        if(level > _csAnalysis->preference_bound())
         {
-            if(scheduling->slot_of(w) != s) continue;
+            if(levelCost > (maxTotalCost / units - 1) / units)
+            {
+                return {};
+            }
 
-            edgesCap.push_back(_inputData->choice(w).max - _inputData->choice(w).min);
-            edgesCost.push_back(0);
+            levelCost = levelCost * units + 1;
+        }
 
-            edgesIdx[std::make_pair(
-                    flow.nodes().at(MipFlowStaticData::node_choice(w)),
-                    flow.nodes().at(MipFlowStaticData::node_slot(s)))]
-                    = nextEdgeIdx++;
+        for(int pref = level; pref < costs.size(); pref++)
+        {
+            costs[pref] = levelCost;
         }
     }
 
-    // Remove all blocked edges
+    return costs;
+}
+
+optional<AssignmentSolver::SlotSolution> AssignmentSolver::solve_slot(const_ptr<Scheduling const> const& scheduling,
+                                                                      int slot,
+                                                                      int preferenceLimit,
+                                                                      vector<long> const& preferenceCosts,
+                                                                      MipSolver& solver)
+{
+    vector<int> choices;
+    for(int w = 0; w < _inputData->choice_count(); w++)
+    {
+        if(scheduling->slot_of(w) == slot) choices.push_back(w);
+    }
+
+    // The slot instance consists of one node per chooser class (see MipFlowStaticData::chooserClasses), one node per
+    // choice in this slot and the slot node.
     //
+    auto const& chooserClasses = _staticData->chooserClasses;
+    int classCount = chooserClasses.size();
+    MipFlow flow;
+    int coveredChoosers = 0;
+
+    for(auto const& chooserClass : chooserClasses)
+    {
+        flow.set_supply(flow.add_node(), chooserClass.size());
+    }
+
+    for(int w : choices)
+    {
+        flow.set_supply(flow.add_node(), -_inputData->choice(w).min);
+        coveredChoosers += _inputData->choice(w).min;
+    }
+
+    int slotNode = flow.add_node();
+    flow.set_supply(slotNode, -(_inputData->chooser_count() - coveredChoosers));
+
     auto blockedEdges = get_blocked_constraint_edges(scheduling);
-    blockedEdges.insert(_staticData->blockedEdges.begin(), _staticData->blockedEdges.end());
 
-    for(auto blocked : blockedEdges)
+    vector<pair<int, int>> edges;
+    for(int c = 0; c < classCount; c++)
     {
-        edgesIdx.erase(blocked);
+        // All choosers of a class have the same preferences and blocked edges, so the first one represents the class.
+        //
+        int p = chooserClasses[c].front();
+
+        for(int i = 0; i < choices.size(); i++)
+        {
+            int w = choices[i];
+
+            if(_inputData->chooser(p).preferences[w] > preferenceLimit) continue;
+            if(blockedEdges[p * _inputData->choice_count() + w]) continue;
+
+            flow.add_edge(
+                    c,
+                    classCount + i,
+                    chooserClasses[c].size(),
+                    preferenceCosts[_inputData->chooser(p).preferences[w]]);
+            edges.emplace_back(c, w);
+        }
     }
 
-    for(auto edge : edgesIdx)
+    for(int i = 0; i < choices.size(); i++)
     {
-        int start = edge.first.first;
-        int end = edge.first.second;
-        int cap = edgesCap[edge.second];
-        long cost = edgesCost[edge.second];
+        int w = choices[i];
+        flow.add_edge(classCount + i, slotNode, _inputData->choice(w).max - _inputData->choice(w).min, 0);
+    }
 
-        flow.add_edge(MipFlowStaticData::edge_id(start, end), start, end, cap, cost);
+    if(!flow.solve(solver, _options->assignment_backend(), _cancellation))
+    {
+        if(flow.interrupted()) _interrupted = true;
+        return std::nullopt;
     }
 
-    // Create edge groups
+    // The flow of a class is handed out to its choosers in order.
     //
-    create_edge_groups(scheduling, flow);
+    vector<int> res(_inputData->chooser_count(), -1);
+    vector<int> assignedCount(classCount, 0);
+    for(int edge = 0; edge < edges.size(); edge++)
+    {
+        auto const& chooserClass = chooserClasses[edges[edge].first];
+        int& assigned = assignedCount[edges[edge].first];
+
+        for(int i = 0; i < flow.solution_value_at(edge); i++)
+        {
+            res[chooserClass[assigned++]] = edges[edge].second;
+        }
+    }
+
+    if(!flow.has_dual_values())
+    {
+        return SlotSolution {res, nullptr};
+    }
+
+    auto duals = std::make_shared<SlotDuals>();
+    duals->choiceDuals.assign(_inputData->choice_count(), flow.dual_value(slotNode));
+    for(int i = 0; i < choices.size(); i++)
+    {
+        duals->choiceDuals[choices[i]] = flow.dual_value(classCount + i);
+    }
+
+    duals->chooserDuals.resize(_inputData->chooser_count());
+    for(int c = 0; c < classCount; c++)
+    {
+        for(int p : chooserClasses[c])
+        {
+            duals->chooserDuals[p] = flow.dual_value(c);
+        }
+    }
+
+    return SlotSolution {res, duals};
+}
+
+optional<int> AssignmentSolver::slot_bottleneck(const_ptr<Scheduling const> const& scheduling,
+                                                int slot,
+                                                vector<bool> const& blockedEdges)
+{
+    vector<int> choices;
+    for(int w = 0; w < _inputData->choice_count(); w++)
+    {
+        if(scheduling->slot_of(w) == slot) choices.push_back(w);
+    }
 
-    // ... and solve this instance
+    // The supplies and demands of the slot instance (see solve_slot) become edges from the source and to the sink.
+    // There is an assignment exactly if the maximum flow saturates all chooser class nodes.
     //
-    if(!flow.solve(solver))
+    auto const& chooserClasses = _staticData->chooserClasses;
+    int chooserCount = _inputData->chooser_count();
+    int classCount = chooserClasses.size();
+    int slotNode = classCount + choices.size();
+    int source = slotNode + 1;
+    int sink = slotNode + 2;
+    int coveredChoosers = 0;
+
+    MaxFlow flow(sink + 1, source, sink);
+
+    for(int c = 0; c < classCount; c++)
     {
-        return nullptr;
+        flow.add_edge(source, c, chooserClasses[c].size());
     }
 
-    // Now we have to extract the assignment solution from the min cost flow solution
+    for(int i = 0; i < choices.size(); i++)
+    {
+        ChoiceData const& choice = _inputData->choice(choices[i]);
+        flow.add_edge(classCount + i, sink, choice.min);
+        flow.add_edge(classCount + i, slotNode, choice.max - choice.min);
+        coveredChoosers += choice.min;
+    }
+
+    if(coveredChoosers > chooserCount)
+    {
+        return std::nullopt;
+    }
+
+    flow.add_edge(slotNode, sink, chooserCount - coveredChoosers);
+
+    // The chooser-choice edges are added level by level, so the flow of the previous levels is kept.
     //
-    vector<vector<int>> data(_inputData->chooser_count(), vector<int>(_inputData->slot_count(), -1));
-    for(int p = 0; p < _inputData->chooser_count(); p++)
+    for(int level : _inputData->preference_levels())
     {
-        for(int s = 0; s < _inputData->slot_count(); s++)
+        for(int c = 0; c < classCount; c++)
         {
-            for(int w = 0; w < _inputData->choice_count(); w++)
+            int p = chooserClasses[c].front();
+
+            for(int i = 0; i < choices.size(); i++)
             {
-                int from = flow.nodes().at(MipFlowStaticData::node_chooser(p, s));
-                int to = flow.nodes().at(MipFlowStaticData::node_choice(w));
+                int w = choices[i];
+                if(_inputData->chooser(p).preferences[w] != level) continue;
+                if(blockedEdges[p * _inputData->choice_count() + w]) continue;
 
-                if(flow.solution_value_at(MipFlowStaticData::edge_id(from, to)) == 1)
-                {
-                    data[p][s] = w;
-                }
+                flow.add_edge(c, classCount + i, chooserClasses[c].size());
             }
         }
+
+        if(level < _csAnalysis->preference_bound()) continue;
+
+        if(flow.augment() == chooserCount)
+        {
+            return level;
+        }
     }
 
-    _lpCount++;
-    return std::make_shared<Assignment const>(_inputData, data);
+    return std::nullopt;
 }
 
-const_ptr<Assignment> AssignmentSolver::solve(const_ptr<Scheduling const> const& scheduling)
+vector<optional<AssignmentSolver::SlotSolution>> AssignmentSolver::solve_slots(
+        const_ptr<Scheduling const> const& scheduling,
+        vector<int> const& slots,
+        int preferenceLimit,
+        vector<long> const& preferenceCosts,
+        MipSolver& solver)
 {
-    auto solver = op::MPSolver("solver", op::MPSolver::CBC_MIXED_INTEGER_PROGRAMMING);
+    vector<optional<SlotSolution>> res(slots.size());
+    int workers = std::min(inner_threads(), (int)slots.size());
 
-    int prefIdx = 0;
-    for(; prefIdx < _inputData->preference_levels().size(); prefIdx++)
+    // The MIP backends are slow enough to always profit from more threads.
+    //
+    AssignmentBackend backend = _options->assignment_backend();
+    int slotEdges = _staticData->chooserClasses.size() * _inputData->choice_count() / _inputData->slot_count();
+    if((backend == AutoBackend || backend == NativeBackend) && slotEdges < MIN_PARALLEL_SLOT_EDGES)
     {
-        if(_inputData->preference_levels().at(prefIdx) == _csAnalysis->preference_bound()) break;
+        workers = 1;
     }
 
-    int minIdx = prefIdx;
-    int maxIdx = _inputData->preference_levels().size();
+    // Worker t solves the slots t, t + workers, t + 2 * workers, ... The calling thread acts as worker 0 and uses the
+    // given solver; every other worker has its own solver.
+    //
+    auto solveSlotsOfWorker = [&](int worker)
+    {
+        MipSolver& workerSolver = worker == 0 ? solver : *_workerSolvers[worker - 1];
+        for(int i = worker; i < slots.size(); i += workers)
+        {
+            res[i] = solve_slot(scheduling, slots[i], preferenceLimit, preferenceCosts, workerSolver);
+        }
+    };
 
-    shared_ptr<Assignment const> bestAssignment = nullptr;
+    if(workers <= 1)
+    {
+        solveSlotsOfWorker(0);
+        return res;
+    }
 
-    if(!_options->greedy())
+    while(_workerSolvers.size() < workers - 1)
     {
-        // We do binary search through all possible preference limits to find the lowest one.
+        _workerSolvers.push_back(std::make_unique<MipSolver>(MipFlow::problem_type(backend, false)));
+        set_time_limit(*_workerSolvers.back());
+    }
+
+    if(_workerPool == nullptr)
+    {
+        _workerPool = std::make_unique<WorkerPool>();
+    }
+
+    _workerPool->run(workers, solveSlotsOfWorker);
+    return res;
+}
+
+const_ptr<Assignment> AssignmentSolver::solve_decomposed(const_ptr<Scheduling const> const& scheduling,
+                                                         const_ptr<Scheduling const> const& parent,
+                                                         MipSolver& solver)
+{
+    if(parent != nullptr && (_parentScheduling == nullptr || *_parentScheduling != *parent))
+    {
+        _parentScheduling = parent;
+        _parentSlotSolutions.clear();
+    }
+
+    // A slot is affected if any choice moved into or out of it. Without a parent, every slot is affected.
+    //
+    vector<bool> affected(_inputData->slot_count(), parent == nullptr);
+    for(int w = 0; parent != nullptr && w < _inputData->choice_count(); w++)
+    {
+        if(scheduling->slot_of(w) == parent->slot_of(w)) continue;
+
+        affected[scheduling->slot_of(w)] = true;
+        affected[parent->slot_of(w)] = true;
+    }
+
+    vector<int> affectedSlots;
+    for(int s = 0; s < _inputData->slot_count(); s++)
+    {
+        if(affected[s]) affectedSlots.push_back(s);
+    }
+
+    // Calculates the solutions of all slots. The parent slot solutions are cached by preference limit.
+    //
+    auto solveAllSlots = [&](int prefLimit)
+    {
+        vector<optional<SlotSolution>> slotSolutions(_inputData->slot_count());
+
+        auto affectedSolutions = solve_slots(scheduling, affectedSlots, prefLimit, _preferenceCosts, solver);
+        for(int i = 0; i < affectedSlots.size(); i++)
+        {
+            slotSolutions[affectedSlots[i]] = affectedSolutions[i];
+        }
+
+        // The unaffected slots are taken from the parent; the ones not solved for the parent yet are solved now.
         //
-        do
+        vector<int> missingSlots;
+        for(int s = 0; s < _inputData->slot_count(); s++)
         {
-            int prefLimit = _inputData->preference_levels().at(prefIdx);
-            auto assignment = solve_with_limit(scheduling, prefLimit, solver);
-            if (assignment == nullptr)
+            if(affected[s]) continue;
+
+            auto it = _parentSlotSolutions.find(std::make_pair(prefLimit, s));
+            if(it == _parentSlotSolutions.end())
             {
-                minIdx = prefIdx + 1;
+                missingSlots.push_back(s);
             }
             else
             {
-                bestAssignment = assignment;
-                maxIdx = prefIdx - 1;
+                slotSolutions[s] = it->second;
             }
-            prefIdx = (maxIdx + minIdx) / 2;
-        } while (maxIdx > minIdx);
+        }
+
+        // Slots of an interrupted solve are not cached, because a missing solution would look like an infeasible one.
+        //
+        auto missingSolutions = solve_slots(parent, missingSlots, prefLimit, _preferenceCosts, solver);
+        for(int i = 0; i < missingSlots.size(); i++)
+        {
+            if(!_interrupted) _parentSlotSolutions[std::make_pair(prefLimit, missingSlots[i])] = missingSolutions[i];
+            slotSolutions[missingSlots[i]] = missingSolutions[i];
+        }
+
+        return slotSolutions;
+    };
+
+    auto solveWithLimit = [&](int prefLimit) -> const_ptr<Assignment>
+    {
+        auto slotSolutions = solveAllSlots(prefLimit);
+
+        vector<vector<int>> data(_inputData->chooser_count(), vector<int>(_inputData->slot_count(), -1));
+        vector<const_ptr<SlotDuals const>> slotDuals;
+        for(int s = 0; s < _inputData->slot_count(); s++)
+        {
+            if(!slotSolutions[s].has_value())
+            {
+                return nullptr;
+            }
+
+            for(int p = 0; p < _inputData->chooser_count(); p++)
+            {
+                data[p][s] = slotSolutions[s]->choices[p];
+            }
+
+            if(slotSolutions[s]->duals != nullptr) slotDuals.push_back(slotSolutions[s]->duals);
+        }
+
+        _lpCount++;
+        auto assignment = std::make_shared<Assignment const>(_inputData, data);
+
+        // The dual values are only kept if all slots provide them.
+        //
+        if(slotDuals.size() == _inputData->slot_count())
+        {
+            _dualsAssignment = assignment;
+            _slotDuals = std::move(slotDuals);
+        }
+
+        return assignment;
+    };
+
+    // Without edge groups, the lowest preference limit is the highest bottleneck of all slots, and the bottleneck of a
+    // slot is a pure max flow question.
+    //
+    auto findBottleneck = [&]() -> optional<int>
+    {
+        auto blockedEdges = get_blocked_constraint_edges(scheduling);
+
+        int bottleneck = 0;
+        for(int s = 0; s < _inputData->slot_count(); s++)
+        {
+            auto slotBottleneck = slot_bottleneck(scheduling, s, blockedEdges);
+            if(!slotBottleneck.has_value())
+            {
+                return _inputData->max_preference();
+            }
+
+            bottleneck = std::max(bottleneck, slotBottleneck.value());
+        }
+
+        return bottleneck;
+    };
+
+    return search_preference_limit(solveWithLimit, findBottleneck);
+}
+
+const_ptr<Assignment> AssignmentSolver::search_preference_limit(
+        std::function<const_ptr<Assignment>(int)> const& solveWithLimit,
+        std::function<optional<int>()> const& findBottleneck,
+        int preferenceLimitHint)
+{
+    _lastProbeCount = 0;
+    auto probeLimit = [&](int prefLimit) -> const_ptr<Assignment>
+    {
+        if(_interrupted) return nullptr;
+
+        _lastProbeCount++;
+        return solveWithLimit(prefLimit);
+    };
+
+    if(!_options->greedy())
+    {
+        // If the lowest possible preference limit can be calculated directly, we only have to solve once with this
+        // limit to also get the optimal minor score.
+        //
+        auto bottleneck = findBottleneck();
+        if(bottleneck.has_value())
+        {
+            return probeLimit(std::max(bottleneck.value(), _csAnalysis->preference_bound()));
+        }
     }
     else
     {
         // In greedy mode, we don't set a preference limit; just solve it.
         //
-        bestAssignment = solve_with_limit(scheduling, _inputData->max_preference(), solver);
+        return probeLimit(_inputData->max_preference());
+    }
+
+    auto const& levels = _inputData->preference_levels();
+
+    // The lowest feasible preference limit is always in levels[minIdx..maxIdx]; maxIdx is the lowest level known to
+    // be feasible (or levels.size() if there is none yet).
+    //
+    int minIdx = 0;
+    while(minIdx < levels.size() && levels[minIdx] < _csAnalysis->preference_bound()) minIdx++;
+
+    int maxIdx = levels.size();
+    shared_ptr<Assignment const> bestAssignment = nullptr;
+
+    auto probe = [&](int idx)
+    {
+        auto assignment = probeLimit(levels[idx]);
+        if(_interrupted)
+        {
+            // An interrupted probe tells nothing about the limit, so the search ends here.
+            //
+            minIdx = maxIdx;
+            return false;
+        }
+
+        if(assignment == nullptr)
+        {
+            minIdx = idx + 1;
+            return false;
+        }
+
+        bestAssignment = assignment;
+        maxIdx = idx;
+        return true;
+    };
+
+    // We start at the hinted preference limit (or at the preference bound) and gallop outward with doubling steps
+    // until the lowest feasible limit is enclosed. Usually, the hint is already the lowest feasible limit, so only one
+    // or two probes are needed.
+    //
+    int hintIdx = minIdx;
+    while(hintIdx < (int)levels.size() - 1 && levels[hintIdx] < preferenceLimitHint) hintIdx++;
+
+    if(minIdx < maxIdx)
+    {
+        bool feasible = probe(hintIdx);
+        for(int step = 1; minIdx < maxIdx; step *= 2)
+        {
+            int idx = feasible
+                    ? std::max(maxIdx - step, minIdx)
+                    : std::min(minIdx - 1 + step, maxIdx - 1);
+
+            if(probe(idx) != feasible) break;
+        }
+    }
+
+    // Then we do binary search through the remaining preference limits.
+    //
+    while(minIdx < maxIdx)
+    {
+        probe((minIdx + maxIdx) / 2);
+    }
+
+    return _interrupted ? nullptr : bestAssignment;
+}
+
+const_ptr<Assignment> AssignmentSolver::solve(const_ptr<Scheduling const> const& scheduling,
+                                              const_ptr<Scheduling const> const& parent,
+                                              int preferenceLimitHint)
+{
+    _interrupted = false;
+    _dualsAssignment = nullptr;
+    _slotDuals.clear();
+    datetime startTime = time_now();
+    const_ptr<Assignment> assignment;
+
+    if(_decomposable)
+    {
+        assignment = solve_decomposed(scheduling, parent, *_solver);
+    }
+    else
+    {
+        // Without independent slots, the inner threads go to the MIP solver instead.
+        //
+        (void)_solver->get().SetNumThreads(inner_threads());
+
+        // The flow template is built only once per scheduling; the preference limit probes below only change edge
+        // bounds.
+        //
+        FlowTemplate& flowTemplate = flow_template(scheduling);
+
+        // The lexicographic option only matters here; on the decomposable path, the bottleneck is always calculated
+        // directly with one max flow per slot.
+        //
+        assignment = search_preference_limit(
+                [&](int prefLimit)
+                {
+                    return solve_with_limit(flowTemplate, prefLimit);
+                },
+                [&]() -> optional<int>
+                {
+                    if(!_options->lexicographic()) return std::nullopt;
+                    return find_bottleneck(flowTemplate);
+                },
+                preferenceLimitHint);
+    }
+
+    if(_threadBudget != nullptr && !_interrupted)
+    {
+        _threadBudget->report_solve(time_now() - startTime);
     }
 
-    return bestAssignment;
+    return assignment;
+}
+
+int AssignmentSolver::inner_threads() const
+{
+    return _threadBudget != nullptr ? _threadBudget->inner_threads() : _slotParallelism;
 }
 
 AssignmentSolver::AssignmentSolver(const_ptr<InputData> inputData,
                                    const_ptr<CriticalSetAnalysis> csAnalysis,
                                    const_ptr<MipFlowStaticData> staticData,
                                    const_ptr<Options> options,
-                                   cancel_token cancellation)
+                                   cancel_token cancellation,
+                                   shared_ptr<ThreadBudget> threadBudget)
     : _inputData(std::move(inputData)),
     _csAnalysis(std::move(csAnalysis)),
     _staticData(std::move(staticData)),
     _options(std::move(options)),
-    _cancellation(std::move(cancellation))
+    _cancellation(std::move(cancellation)),
+    _threadBudget(std::move(threadBudget)),
+    _deadline(time_now() + seconds(_options->timeout_seconds()))
 {
+    // Without edge groups, every chooser-slot node is only connected to the choices of its slot, so the flow instance
+    // falls apart into one independent instance per slot.
+    //
+    _decomposable = true;
+    for(Constraint const& constraint : _inputData->assignment_constraints())
+    {
+        if(constraint.type() == ChoosersHaveSameChoices) _decomposable = false;
+    }
+
+    for(vector<int> const& group : _inputData->dependent_choice_groups())
+    {
+        if(group.size() > 1) _decomposable = false;
+    }
+
+    // Without a thread budget, the slots are solved concurrently only with the cores that are not already occupied by
+    // the solver threads.
+    //
+    _slotParallelism = std::max(1, (int)std::thread::hardware_concurrency() / std::max(1, _options->thread_count()));
+
+    _solver = std::make_unique<MipSolver>(MipFlow::problem_type(_options->assignment_backend(), !_decomposable));
+    set_time_limit(*_solver);
+
+    _preferenceCosts.resize(_inputData->max_preference() + 1);
+    for(int pref = 0; pref <= _inputData->max_preference(); pref++)
+    {
+        _preferenceCosts[pref] = (long)pow(pref + 1.0, _options->preference_exponent());
+    }
 }
 
 int AssignmentSolver::lp_count() const
 {
     return _lpCount;
 }
+
+bool AssignmentSolver::interrupted() const
+{
+    return _interrupted;
+}
+
+int AssignmentSolver::last_probe_count() const
+{
+    return _lastProbeCount;
+}
+
+vector<const_ptr<AssignmentSolver::SlotDuals const>> AssignmentSolver::slot_duals(Assignment const& assignment) const
+{
+    if(_dualsAssignment.get() != &assignment)
+    {
+        return {};
+    }
+
+    return _slotDuals;
+}
+
+double AssignmentSolver::reduced_cost(SlotDuals const& duals, int p, int w) const
+{
+    return _preferenceCosts[_inputData->chooser(p).preferences[w]] - duals.chooserDuals[p] + duals.choiceDuals[w];
+}
@@ -22,9 +22,11 @@
 #include "CriticalSetAnalysis.h"
 #include "MipFlowStaticData.h"
 #include "Score.h"
-#include "MipFlowStaticData.h"
+#include "ThreadBudget.h"
+#include "WorkerPool.h"
 
 #include <future>
+#include <functional>
 #include <climits>
 #include <utility>
 
@@ -35,32 +37,183 @@ namespace op = operations_research;
  */
 class AssignmentSolver
 {
+public:
+    /**
+     * The dual values of a solved slot instance (see solve_slot). Assigning chooser p to choice w in the slot has the
+     * reduced cost c(p, w) - chooserDuals[p] + choiceDuals[w] (see reduced_cost). Choices that are not in the slot get
+     * the dual value of the slot node, because they would be connected to it by an edge without cost.
+     */
+    struct SlotDuals
+    {
+        vector<double> chooserDuals;
+        vector<double> choiceDuals;
+    };
+
 private:
+    /**
+     * Handing a slot instance to another thread costs more than solving a small one with the native min cost flow
+     * solver, so slots are only solved concurrently if they have at least about this many chooser-choice edges.
+     */
+    static const int MIN_PARALLEL_SLOT_EDGES = 1000;
+
     const_ptr<InputData> _inputData;
     const_ptr<CriticalSetAnalysis> _csAnalysis;
     const_ptr<MipFlowStaticData> _staticData;
     const_ptr<Options> _options;
     cancel_token _cancellation;
+    shared_ptr<ThreadBudget> _threadBudget;
+    datetime _deadline;
 
     int _lpCount = 0;
+    int _lastProbeCount = 0;
+    atomic<bool> _interrupted = false;
+
+    /**
+     * The flow instance of a single scheduling. The edge preferences are indexed by edge (edges that are not subject
+     * to the preference limit have a preference of -1), the chooser edges by p * choice_count + w (-1 if blocked).
+     * The limited edges are all edges with a preference, sorted by preference; the first enabledEdges of them are
+     * currently enabled.
+     */
+    struct FlowTemplate
+    {
+        const_ptr<Scheduling const> scheduling;
+        MipFlow flow;
+        vector<int> edgePreferences;
+        vector<int> chooserEdges;
+        vector<int> limitedEdges;
+        int enabledEdges = 0;
+    };
+
+    /**
+     * The solution of a single slot instance: the choice of every chooser in the slot (see solve_slot) and the dual
+     * values of the slot instance, or nullptr if the backend does not provide them.
+     */
+    struct SlotSolution
+    {
+        vector<int> choices;
+        const_ptr<SlotDuals const> duals;
+    };
+
+    unique_ptr<MipSolver> _solver;
+    unique_ptr<FlowTemplate> _flowTemplate;
+    vector<unique_ptr<MipSolver>> _workerSolvers;
+    unique_ptr<WorkerPool> _workerPool;
+
+    bool _decomposable;
+    int _slotParallelism;
+    vector<long> _preferenceCosts;
+    const_ptr<Scheduling const> _parentScheduling;
+    map<pair<int, int>, optional<SlotSolution>> _parentSlotSolutions;
+    const_ptr<Assignment const> _dualsAssignment;
+    vector<const_ptr<SlotDuals const>> _slotDuals;
+
+    /**
+     * Returns the number of threads a single solve may use.
+     */
+    [[nodiscard]] int inner_threads() const;
+
+    /**
+     * Applies the assignment timeout of the options to the given MIP solver. If this solver can be cancelled, the MIP
+     * solver also gets the end of the global timeout as deadline, in case it cannot be interrupted.
+     */
+    void set_time_limit(MipSolver& solver) const;
 
     /**
      * Calculates edges in the flow graph that have to be removed from the flow graph. For example, a ChooserIsInChoice
-     * constraint causes all edges except for the one constrained choice to be blocked.
+     * constraint causes all edges except for the one constrained choice to be blocked. Returns a vector v where
+     * v[p * choice_count + w] is true if the edge between chooser p and choice w is blocked.
      */
-    set<pair<int, int>> get_blocked_constraint_edges(shared_ptr<Scheduling const> const& scheduling);
+    vector<bool> get_blocked_constraint_edges(shared_ptr<Scheduling const> const& scheduling);
 
     /**
      * Creates edge groups for dependent choices and ChoosersHaveSameChoices constraints.
      */
-    void create_edge_groups(const_ptr<Scheduling> const& scheduling, MipFlow<flowid, flowid>& flow);
+    void create_edge_groups(MipFlow& flow, vector<int> const& chooserEdges);
+
+    /**
+     * Returns the flow template of the last scheduling solved with edge groups, or builds a new one for the given
+     * scheduling. The template contains the chooser-choice edges of all preferences, so it can be reused for every
+     * preference limit.
+     */
+    FlowTemplate& flow_template(const_ptr<Scheduling const> const& scheduling);
+
+    /**
+     * Enables exactly the chooser-choice edges of the given flow template whose preference does not exceed the given
+     * preference limit. Only the edges whose state changes are touched.
+     */
+    static void set_preference_limit(FlowTemplate& flowTemplate, int preferenceLimit);
 
     /**
-     * Calculates an optimal assignment for the given scheduling, considering the given preference limit.
+     * Calculates an optimal assignment for the given flow template, considering the given preference limit. Only the
+     * edge bounds of the flow instance are changed, so the MIP model can be kept in the solver between calls.
      */
-    const_ptr<Assignment> solve_with_limit(const_ptr<Scheduling> const& scheduling,
-                                                  int preferenceLimit,
-                                                  op::MPSolver& solver);
+    const_ptr<Assignment> solve_with_limit(FlowTemplate& flowTemplate, int preferenceLimit);
+
+    /**
+     * Calculates the lowest preference limit for which an assignment exists with a single solve of the given flow
+     * template using lexicographic costs (see lexicographic_costs). Returns nothing if the costs would get too large.
+     */
+    optional<int> find_bottleneck(FlowTemplate& flowTemplate);
+
+    /**
+     * Calculates edge costs (indexed by preference) that grow so steeply with the preference level that every min cost
+     * flow with the given number of flow units minimizes the maximum used preference first. Returns an empty vector if
+     * the costs would get too large.
+     */
+    [[nodiscard]] vector<long> lexicographic_costs(int units) const;
+
+    /**
+     * Performs the search for the lowest preference limit for which an assignment exists. The first given function has
+     * to calculate an assignment for a given preference limit (or return nullptr if there is none). The second given
+     * function may calculate the lowest preference limit directly; if it returns nothing, the limits are searched
+     * starting at the given hint, first galloping outward and then by binary search.
+     */
+    const_ptr<Assignment> search_preference_limit(std::function<const_ptr<Assignment>(int)> const& solveWithLimit,
+                                                  std::function<optional<int>()> const& findBottleneck,
+                                                  int preferenceLimitHint = -1);
+
+    /**
+     * Calculates an optimal assignment of all choosers within a single slot, considering the given preference limit
+     * and edge costs (indexed by preference). This is only valid if the assignment problem is decomposable into
+     * independent slots (which is the case if there are no edge groups). Returns the solution of the slot, where
+     * choices[p] is the choice of chooser p in this slot, or nothing if there is no valid assignment.
+     */
+    optional<SlotSolution> solve_slot(const_ptr<Scheduling const> const& scheduling,
+                                      int slot,
+                                      int preferenceLimit,
+                                      vector<long> const& preferenceCosts,
+                                      MipSolver& solver);
+
+    /**
+     * Calculates the lowest preference limit for which an assignment of all choosers within a single slot exists,
+     * using an incremental max flow instead of solving the slot instance for every limit. The result is never lower
+     * than the preference bound of the critical set analysis. Returns nothing if there is no assignment at all.
+     */
+    optional<int> slot_bottleneck(const_ptr<Scheduling const> const& scheduling,
+                                  int slot,
+                                  vector<bool> const& blockedEdges);
+
+    /**
+     * Calculates optimal assignments for the given slots (see solve_slot). The slots are solved concurrently if there
+     * are idle cores and the slot instances are not too small. The worker threads and their MIP solvers are kept for
+     * later calls. Returns a vector v where v[i] is the solution of the slot slots[i].
+     */
+    vector<optional<SlotSolution>> solve_slots(const_ptr<Scheduling const> const& scheduling,
+                                               vector<int> const& slots,
+                                               int preferenceLimit,
+                                               vector<long> const& preferenceCosts,
+                                               MipSolver& solver);
+
+    /**
+     * Calculates an optimal assignment for the given scheduling by solving every slot separately. This is only valid
+     * if the assignment problem is decomposable into independent slots. If a parent scheduling is given, the per-slot
+     * solutions of the parent are reused for all slots that contain the same choices in both schedulings, so only the
+     * slots affected by the difference between the two schedulings are solved again.
+     */
+    const_ptr<Assignment> solve_decomposed(const_ptr<Scheduling const> const& scheduling,
+                                           const_ptr<Scheduling const> const& parent,
+                                           MipSolver& solver);
+
 public:
     /**
      * Constructor.
@@ -70,22 +223,57 @@ public:
      * @param staticData The static flow data to use for calculation.
      * @param options The options.
      * @param cancellation An optional cancellation token.
+     * @param threadBudget An optional thread budget that determines how many threads a single solve may use and that
+     * the solve times are reported to.
      */
     AssignmentSolver(const_ptr<InputData> inputData,
                      const_ptr<CriticalSetAnalysis> csAnalysis,
                      const_ptr<MipFlowStaticData> staticData,
                      const_ptr<Options> options,
-                     cancel_token cancellation = cancel_token());
+                     cancel_token cancellation = cancel_token(),
+                     shared_ptr<ThreadBudget> threadBudget = nullptr);
 
     /**
-     * Calculates an optimal assignment for the given scheduling.
+     * Calculates an optimal assignment for the given scheduling. If the assignment problem does not contain edge
+     * groups, every slot is solved separately.
+     *
+     * @param parent An optional scheduling that the given scheduling was derived from (e.g. by a hill climbing move).
+     * If given and the assignment problem does not contain edge groups, only the slots that differ from the parent are
+     * solved again and the solutions of all other slots are taken from the parent.
+     * @param preferenceLimitHint An optional guess of the lowest feasible preference limit, usually the maximum used
+     * preference of the parent's assignment. If the preference limits have to be searched, the search starts there.
      */
-    const_ptr<Assignment> solve(shared_ptr<Scheduling const> const& scheduling);
+    const_ptr<Assignment> solve(shared_ptr<Scheduling const> const& scheduling,
+                                shared_ptr<Scheduling const> const& parent = nullptr,
+                                int preferenceLimitHint = -1);
 
     /**
      * Returns the number of solved LP (or MIP) instances so far.
      */
      [[nodiscard]] int lp_count() const;
+
+    /**
+     * Returns true if the last call to solve was interrupted by the cancellation token or the assignment timeout. The
+     * result of such a call is always nullptr and must not be mistaken for an infeasible scheduling.
+     */
+    [[nodiscard]] bool interrupted() const;
+
+    /**
+     * Returns the number of preference limits that were probed during the last call to solve.
+     */
+    [[nodiscard]] int last_probe_count() const;
+
+    /**
+     * Returns the dual values of the slot instances (indexed by slot) that the given assignment was calculated with. The
+     * result is empty if the given assignment is not the last one calculated by solve, if it was not calculated slot by
+     * slot (because of edge groups) or if the backend does not provide dual values (CBC and CP-SAT).
+     */
+    [[nodiscard]] vector<const_ptr<SlotDuals const>> slot_duals(Assignment const& assignment) const;
+
+    /**
+     * Returns the reduced cost of assigning the given chooser to the given choice in a slot with the given dual values.
+     */
+    [[nodiscard]] double reduced_cost(SlotDuals const& duals, int p, int w) const;
 };
 
 
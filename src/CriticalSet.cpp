@@ -22,6 +22,16 @@ CriticalSet::CriticalSet(int preference, vector<int> const& data)
         : _preference(preference)
 {
     _data.insert(data.begin(), data.end());
+
+    if(!_data.empty())
+    {
+        _bits.resize(*_data.rbegin() / 64 + 1, 0);
+    }
+
+    for(int item : _data)
+    {
+        _bits[item / 64] |= uint64_t(1) << (item % 64);
+    }
 }
 
 bool CriticalSet::is_covered_by(CriticalSet const& other) const
@@ -31,12 +41,22 @@ bool CriticalSet::is_covered_by(CriticalSet const& other) const
 
 bool CriticalSet::is_superset_of(CriticalSet const& other) const
 {
-    return std::includes(_data.begin(), _data.end(), other._data.begin(), other._data.end());
+    if(other._bits.size() > _bits.size())
+    {
+        return false;
+    }
+
+    for(int i = 0; i < other._bits.size(); i++)
+    {
+        if((other._bits[i] & ~_bits[i]) != 0) return false;
+    }
+
+    return true;
 }
 
 bool CriticalSet::contains(int item) const
 {
-    return _data.find(item) != _data.end();
+    return item / 64 < _bits.size() && (_bits[item / 64] >> (item % 64) & 1) != 0;
 }
 
 int CriticalSet::size() const
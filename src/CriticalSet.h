@@ -18,6 +18,8 @@
 
 #include "Types.h"
 
+#include <cstdint>
+
 /**
  * A critical set consists of a set S of choices and a preference P, such that in each solution with a maximum
  * preference of P, each slot must contain at least one choice in S.
@@ -26,6 +28,7 @@ class CriticalSet
 {
 private:
     ordered_set<int> _data;
+    vector<uint64_t> _bits;
     int _preference;
 
 public:
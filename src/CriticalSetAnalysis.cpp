@@ -126,16 +126,31 @@ void CriticalSetAnalysis::analyze()
 }
 
 CriticalSetAnalysis::CriticalSetAnalysis(const_ptr<InputData> inputData, bool analyze)
-        : _inputData(std::move(inputData))
+        : _inputData(std::move(inputData)),
+          _noSetsOfChoice(_inputData->choice_count())
 {
     if(analyze)
     {
         this->analyze();
 
+        for(int prefLevel : _inputData->preference_levels())
+        {
+            _setsByLevel.push_back(calculate_for_preference(prefLevel));
+
+            auto& setsOfChoice = _setsOfChoiceByLevel.emplace_back(_inputData->choice_count());
+            for(int k = 0; k < _setsByLevel.back().size(); k++)
+            {
+                for(int w : _setsByLevel.back()[k].elements())
+                {
+                    setsOfChoice[w].push_back(k);
+                }
+            }
+        }
+
         preferenceBound = _inputData->max_preference();
         for(int prefLevel : _inputData->preference_levels())
         {
-            auto subset = for_preference(prefLevel);
+            auto const& subset = for_preference(prefLevel);
             if(!subset.empty() && subset.front().size() >= _inputData->slot_count())
             {
                 preferenceBound = std::min(preferenceBound, prefLevel);
@@ -148,7 +163,36 @@ CriticalSetAnalysis::CriticalSetAnalysis(const_ptr<InputData> inputData, bool an
     }
 }
 
-vector<CriticalSet> CriticalSetAnalysis::for_preference(int preference) const
+int CriticalSetAnalysis::level_index(int preference) const
+{
+    // Relevant sets only change at preference levels, so the next level at or above the given preference is used.
+    //
+    auto const& levels = _inputData->preference_levels();
+    auto levelIt = std::lower_bound(levels.begin(), levels.end(), preference);
+
+    if(levelIt == levels.end() || levelIt - levels.begin() >= _setsByLevel.size())
+    {
+        return -1;
+    }
+
+    return levelIt - levels.begin();
+}
+
+vector<CriticalSet> const& CriticalSetAnalysis::for_preference(int preference) const
+{
+    static vector<CriticalSet> const noSets;
+
+    int level = level_index(preference);
+    return level >= 0 ? _setsByLevel[level] : noSets;
+}
+
+vector<vector<int>> const& CriticalSetAnalysis::sets_of_choice(int preference) const
+{
+    int level = level_index(preference);
+    return level >= 0 ? _setsOfChoiceByLevel[level] : _noSetsOfChoice;
+}
+
+vector<CriticalSet> CriticalSetAnalysis::calculate_for_preference(int preference) const
 {
     list<CriticalSet> relevantSets{};
     for(CriticalSet set : _sets)
@@ -159,7 +203,6 @@ vector<CriticalSet> CriticalSetAnalysis::for_preference(int preference) const
         }
     }
 
-    // TODO: Cache this method so we don't have to do this simplification step (and the sort below) every time.
     bool changed = true;
     while(changed)
     {
@@ -31,11 +31,36 @@ private:
     const_ptr<InputData> _inputData;
     int preferenceBound;
 
+    /**
+     * The simplified and sorted critical sets for each preference level (in the order of the preference levels of the
+     * input data), see for_preference.
+     */
+    vector<vector<CriticalSet>> _setsByLevel;
+
+    /**
+     * For each preference level, the indices of the critical sets of the level (see for_preference) containing each
+     * choice. _noSetsOfChoice is the index for preferences without critical sets.
+     */
+    vector<vector<vector<int>>> _setsOfChoiceByLevel;
+    vector<vector<int>> _noSetsOfChoice;
+
+    /**
+     * Returns the index of the lowest preference level at or above the given preference that has cached critical
+     * sets, or -1 if there is none.
+     */
+    [[nodiscard]] int level_index(int preference) const;
+
     /**
      * Performs the analysis.
      */
     void analyze();
 
+    /**
+     * Calculates all critical sets relevant for the given preference bound, without those that are supersets of other
+     * relevant sets, sorted by size.
+     */
+    [[nodiscard]] vector<CriticalSet> calculate_for_preference(int preference) const;
+
 public:
     /**
      * After this amount of time, progress updates will be printed to the output while analyzing.
@@ -55,9 +80,16 @@ public:
     explicit CriticalSetAnalysis(const_ptr<InputData> inputData, bool analyze = true);
 
     /**
-     * Returns all critical sets relevant for the given preference bound.
+     * Returns all critical sets relevant for the given preference bound. These are calculated once for each preference
+     * level when the analysis is performed.
+     */
+    [[nodiscard]] vector<CriticalSet> const& for_preference(int preference) const;
+
+    /**
+     * Returns the indices of the critical sets returned by for_preference that contain each choice (indexed by
+     * choice).
      */
-    [[nodiscard]] vector<CriticalSet> for_preference(int preference) const;
+    [[nodiscard]] vector<vector<int>> const& sets_of_choice(int preference) const;
 
     /**
      * Returns all critical sets.
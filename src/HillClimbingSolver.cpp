@@ -16,25 +16,46 @@
 
 #include "HillClimbingSolver.h"
 #include "Util.h"
+#include "UnionFind.h"
 
 #include <utility>
+#include <numeric>
+#include <cmath>
 
 int HillClimbingSolver::max_neighbor_key()
 {
     return _inputData->choice_count() * (_inputData->slot_count() - 1);
 }
 
-shared_ptr<Assignment const> HillClimbingSolver::solve_assignment(const_ptr<Scheduling const> const& scheduling)
+shared_ptr<Assignment const> HillClimbingSolver::solve_assignment(const_ptr<Scheduling const> const& scheduling,
+                                                                  const_ptr<Scheduling const> const& parent,
+                                                                  int preferenceLimitHint)
 {
-    auto res = _assignmentSolver.solve(scheduling);
+    const_ptr<Assignment const> res;
+    if(_assignmentCache != nullptr && _assignmentCache->try_get(*scheduling, res))
+    {
+        return res;
+    }
+
+    res = _assignmentSolver.solve(scheduling, parent, preferenceLimitHint);
     _assignmentCount++;
+
+    if(_assignmentSolver.interrupted())
+    {
+        return nullptr;
+    }
+
+    if(_assignmentCache != nullptr)
+    {
+        _assignmentCache->insert(*scheduling, res);
+    }
+
     return res;
 }
 
-shared_ptr<Scheduling const> HillClimbingSolver::neighbor(shared_ptr<Scheduling const> const& scheduling, int neighborKey)
+HillClimbingSolver::Move HillClimbingSolver::relocation_move(shared_ptr<Scheduling const> const& scheduling,
+                                                             int neighborKey)
 {
-    vector<int> data(scheduling->raw_data());
-
     int s = neighborKey / _inputData->choice_count();
     int w = neighborKey % _inputData->choice_count();
 
@@ -43,31 +64,314 @@ shared_ptr<Scheduling const> HillClimbingSolver::neighbor(shared_ptr<Scheduling
         s += 1;
     }
 
-    data[w] = s;
+    return {{w, s}};
+}
+
+HillClimbingSolver::Move HillClimbingSolver::sample_swap_move(shared_ptr<Scheduling const> const& scheduling,
+                                                              vector<int> const& leaders)
+{
+    int a = leaders[Rng::next(0, leaders.size())];
+    int b = leaders[Rng::next(0, leaders.size())];
+
+    if(scheduling->slot_of(a) == scheduling->slot_of(b))
+    {
+        return {};
+    }
+
+    return {{a, scheduling->slot_of(b)}, {b, scheduling->slot_of(a)}};
+}
+
+HillClimbingSolver::Move HillClimbingSolver::sample_chain_move(shared_ptr<Scheduling const> const& scheduling,
+                                                               vector<int> const& leaders)
+{
+    int a = leaders[Rng::next(0, leaders.size())];
+    int b = leaders[Rng::next(0, leaders.size())];
+    int c = leaders[Rng::next(0, leaders.size())];
+
+    int sa = scheduling->slot_of(a);
+    int sb = scheduling->slot_of(b);
+    int sc = scheduling->slot_of(c);
+
+    if(sa == sb || sb == sc || sa == sc)
+    {
+        return {};
+    }
+
+    return {{a, sb}, {b, sc}, {c, sa}};
+}
+
+shared_ptr<Scheduling const> HillClimbingSolver::neighbor(shared_ptr<Scheduling const> const& scheduling,
+                                                          Move const& move)
+{
+    vector<int> data(scheduling->raw_data());
+
+    for(auto const& [w, s] : move)
+    {
+        int offset = s - scheduling->slot_of(w);
+        for(int other : _rigidGroups[_rigidGroupOf[w]])
+        {
+            data[other] += offset;
+            if(data[other] < 0 || data[other] >= _inputData->slot_count()) return nullptr;
+        }
+    }
+
     auto newScheduling = std::make_shared<Scheduling const>(_inputData, data);
 
     return newScheduling;
 }
 
-vector<shared_ptr<Scheduling const>> HillClimbingSolver::pick_neighbors(shared_ptr<Scheduling const> const& scheduling)
+bool HillClimbingSolver::satisfies_moved_constraints(Scheduling const& neighbor,
+                                                     vector<int> const& movedChoices,
+                                                     vector<int> const& slotSizes)
+{
+    for(int w : movedChoices)
+    {
+        for(Constraint const& constraint : _inputData->scheduling_constraints(w))
+        {
+            int l = constraint.left();
+            int r = constraint.right();
+            int e = constraint.extra();
+
+            switch(constraint.type())
+            {
+                case ChoiceIsInSlot:
+                    if(neighbor.slot_of(l) != r) return false;
+                    break;
+
+                case ChoiceIsNotInSlot:
+                    if(neighbor.slot_of(l) == r) return false;
+                    break;
+
+                case ChoicesAreInSameSlot:
+                    if(neighbor.slot_of(l) != neighbor.slot_of(r)) return false;
+                    break;
+
+                case ChoicesAreNotInSameSlot:
+                    if(neighbor.slot_of(l) == neighbor.slot_of(r)) return false;
+                    break;
+
+                case ChoicesHaveOffset:
+                    if(neighbor.slot_of(r) - neighbor.slot_of(l) != e) return false;
+                    break;
+
+                case SlotHasLimitedSize:
+                {
+                    int count = slotSizes[l];
+                    switch((SlotSizeLimitOp)e)
+                    {
+                        case Eq: if(count != r) return false; break;
+                        case Neq: if(count == r) return false; break;
+                        case Gt: if(count <= r) return false; break;
+                        case Lt: if(count >= r) return false; break;
+                        case Geq: if(count < r) return false; break;
+                        case Leq: if(count > r) return false; break;
+                        default: throw std::logic_error("Unknown slot size limit operator " + str(e) + ".");
+                    }
+                    break;
+                }
+
+                default: throw std::logic_error("Unknown scheduling constraint type " + str(constraint.type()) + ".");
+            }
+        }
+    }
+
+    return true;
+}
+
+vector<int> HillClimbingSolver::guided_neighbor_keys(
+        shared_ptr<Scheduling const> const& scheduling,
+        shared_ptr<Assignment const> const& assignment,
+        vector<const_ptr<AssignmentSolver::SlotDuals const>> const& slotDuals)
+{
+    int choiceCount = _inputData->choice_count();
+
+    // The cost of assigning a chooser to a choice in a slot is its reduced cost in the slot instance, which also prices
+    // the choice bounds of the slot. As a fallback for backends without dual values (CBC and CP-SAT) and for
+    // assignments with edge groups, the plain edge cost is used instead.
+    //
+    auto cost = [&](int p, int w, int s)
+    {
+        if(slotDuals.empty()) return _preferenceCosts[_inputData->chooser(p).preferences[w]];
+        return _assignmentSolver.reduced_cost(*slotDuals[s], p, w);
+    };
+
+    vector<vector<int>> slotChoices(_inputData->slot_count());
+    for(int w = 0; w < choiceCount; w++)
+    {
+        slotChoices[scheduling->slot_of(w)].push_back(w);
+    }
+
+    // The loss of moving a choice away: each of its choosers falls back to their next best choice in the same slot.
+    //
+    vector<double> loss(choiceCount, 0);
+    for(int p = 0; p < _inputData->chooser_count(); p++)
+    {
+        for(int s = 0; s < _inputData->slot_count(); s++)
+        {
+            int w = assignment->choice_of(p, s);
+            double fallbackCost = INFINITY;
+
+            for(int other : slotChoices[s])
+            {
+                if(other != w) fallbackCost = std::min(fallbackCost, cost(p, other, s));
+            }
+
+            loss[w] += fallbackCost - cost(p, w, s);
+        }
+    }
+
+    // The gain of moving a choice to a slot: the choosers of this slot that would improve the most by switching to the
+    // choice fill it up to its maximum.
+    //
+    vector<pair<double, int>> estimates;
+    vector<double> gains;
+    for(int w = 0; w < choiceCount; w++)
+    {
+        for(int s = 0; s < _inputData->slot_count(); s++)
+        {
+            if(s == scheduling->slot_of(w)) continue;
+
+            gains.clear();
+            for(int p = 0; p < _inputData->chooser_count(); p++)
+            {
+                double gain = cost(p, assignment->choice_of(p, s), s) - cost(p, w, s);
+                if(gain > 0) gains.push_back(gain);
+            }
+
+            int count = std::min((int)gains.size(), _inputData->choice(w).max);
+            std::nth_element(gains.begin(), gains.begin() + count, gains.end(), std::greater<>());
+
+            double gain = std::accumulate(gains.begin(), gains.begin() + count, 0.0);
+            int neighborKey = (s > scheduling->slot_of(w) ? s - 1 : s) * choiceCount + w;
+            estimates.emplace_back(gain - loss[w], neighborKey);
+        }
+    }
+
+    // Neighbors with equal estimates are still explored in random order.
+    //
+    std::shuffle(estimates.begin(), estimates.end(), Rng::engine());
+    std::stable_sort(estimates.begin(), estimates.end(), [](auto const& a, auto const& b)
+    {
+        return a.first > b.first;
+    });
+
+    vector<int> neighborKeys;
+    for(auto const& estimate : estimates)
+    {
+        neighborKeys.push_back(estimate.second);
+    }
+
+    return neighborKeys;
+}
+
+vector<shared_ptr<Scheduling const>> HillClimbingSolver::pick_neighbors(
+        shared_ptr<Scheduling const> const& scheduling,
+        shared_ptr<Assignment const> const& assignment,
+        vector<const_ptr<AssignmentSolver::SlotDuals const>> const& slotDuals)
 {
     vector<shared_ptr<Scheduling const>> result;
+    vector<int> neighborKeys;
 
-    vector<int> neighborKeys(max_neighbor_key());
-    std::iota(neighborKeys.begin(), neighborKeys.end(), 0);
+    if(_options->guided_neighbors() && assignment != nullptr)
+    {
+        neighborKeys = guided_neighbor_keys(scheduling, assignment, slotDuals);
+    }
+    else
+    {
+        neighborKeys.resize(max_neighbor_key());
+        std::iota(neighborKeys.begin(), neighborKeys.end(), 0);
 
-    if(max_neighbor_key() > _options->max_neighbors())
+        if(max_neighbor_key() > _options->max_neighbors())
+        {
+            std::shuffle(neighborKeys.begin(), neighborKeys.end(), Rng::engine());
+        }
+    }
+
+    vector<int> slotSizes(_inputData->slot_count(), 0);
+    for(int w = 0; w < _inputData->choice_count(); w++)
     {
-        std::shuffle(neighborKeys.begin(), neighborKeys.end(), Rng::engine());
+        slotSizes[scheduling->slot_of(w)]++;
     }
 
-    for(int keyIdx = 0; keyIdx < neighborKeys.size(); keyIdx++)
+    // A rigid group is only moved through its first choice (its leader); moving the other choices of the group would
+    // yield the same neighbors.
+    //
+    vector<int> leaders;
+    for(auto const& group : _rigidGroups)
     {
-        if(keyIdx > _options->max_neighbors() * 32) break;
+        leaders.push_back(group.front());
+    }
+
+    bool swapsPossible = leaders.size() >= 2;
+    bool chainsPossible = leaders.size() >= 3 && _inputData->slot_count() >= 3;
+
+    // Relocations, swaps and chains take turns. Compound moves are sampled since there are too many to enumerate; the
+    // number of generated candidates is bounded either way. If all relocations fit into the neighbor limit, they are
+    // all generated first and only the remaining budget goes to compound moves.
+    //
+    bool enumerateRelocations = max_neighbor_key() <= _options->max_neighbors();
+    ordered_set<vector<int>> sampledMoves;
+    int relocationIdx = 0;
+    int generatedCount = 0;
+    for(int round = 0; generatedCount <= _options->max_neighbors() * 32; round++)
+    {
+        Move move;
+
+        if(round % 3 == 0 || (enumerateRelocations && relocationIdx < neighborKeys.size()))
+        {
+            if(relocationIdx == neighborKeys.size())
+            {
+                if(!swapsPossible) break;
+                continue;
+            }
+
+            int neighborKey = neighborKeys[relocationIdx++];
+            int w = neighborKey % _inputData->choice_count();
+            if(_rigidGroups[_rigidGroupOf[w]].front() != w) continue;
 
-        int neighborKey = neighborKeys[keyIdx];
-        auto nextNeighbor = neighbor(scheduling, neighborKey);
-        if(!nextNeighbor->is_feasible()) continue;
+            generatedCount++;
+            move = relocation_move(scheduling, neighborKey);
+        }
+        else
+        {
+            if(round % 3 == 1 ? !swapsPossible : !chainsPossible) continue;
+
+            generatedCount++;
+            move = round % 3 == 1 ? sample_swap_move(scheduling, leaders) : sample_chain_move(scheduling, leaders);
+            if(move.empty()) continue;
+
+            // Cycles are identified by their choices, starting with the smallest one.
+            //
+            vector<int> cycle;
+            for(auto const& [w, s] : move)
+            {
+                cycle.push_back(w);
+            }
+
+            std::rotate(cycle.begin(), std::min_element(cycle.begin(), cycle.end()), cycle.end());
+            if(!sampledMoves.insert(cycle).second) continue;
+        }
+
+        auto nextNeighbor = neighbor(scheduling, move);
+        if(nextNeighbor == nullptr || !nextNeighbor->is_feasible()) continue;
+
+        vector<int> movedChoices;
+        for(auto const& [w, s] : move)
+        {
+            auto const& group = _rigidGroups[_rigidGroupOf[w]];
+            movedChoices.insert(movedChoices.end(), group.begin(), group.end());
+        }
+
+        // The scheduling constraints are checked before any assignment is solved, but only those of the moved choices.
+        //
+        vector<int> neighborSlotSizes(slotSizes);
+        for(int moved : movedChoices)
+        {
+            neighborSlotSizes[scheduling->slot_of(moved)]--;
+            neighborSlotSizes[nextNeighbor->slot_of(moved)]++;
+        }
+
+        if(!satisfies_moved_constraints(*nextNeighbor, movedChoices, neighborSlotSizes)) continue;
 
         result.push_back(nextNeighbor);
 
@@ -85,15 +389,45 @@ HillClimbingSolver::HillClimbingSolver(const_ptr<InputData> inputData,
                                        const_ptr<MipFlowStaticData> staticData,
                                        const_ptr<Scoring> scoring,
                                        const_ptr<Options> options,
-                                       cancel_token cancellation)
+                                       cancel_token cancellation,
+                                       shared_ptr<AssignmentCache> assignmentCache,
+                                       shared_ptr<ThreadBudget> threadBudget)
     : _inputData(std::move(inputData)),
     _csAnalysis(std::move(csAnalysis)),
     _staticData(std::move(staticData)),
     _scoring(std::move(scoring)),
     _options(std::move(options)),
     _cancellation(std::move(cancellation)),
-    _assignmentSolver(_inputData, _csAnalysis, _staticData, _options, _cancellation)
+    _assignmentCache(std::move(assignmentCache)),
+    _assignmentSolver(_inputData, _csAnalysis, _staticData, _options, _cancellation, std::move(threadBudget))
 {
+    // Choices connected by ChoicesHaveOffset or ChoicesAreInSameSlot constraints always have to move together.
+    //
+    UnionFind<int> rigidChoices(_inputData->choice_count());
+    for(Constraint const& constraint : _inputData->scheduling_constraints())
+    {
+        if(constraint.type() == ChoicesHaveOffset || constraint.type() == ChoicesAreInSameSlot)
+        {
+            rigidChoices.join(constraint.left(), constraint.right());
+        }
+    }
+
+    _rigidGroupOf.resize(_inputData->choice_count());
+    map<int, int> groupIndexes;
+    for(int w = 0; w < _inputData->choice_count(); w++)
+    {
+        auto it = groupIndexes.emplace(rigidChoices.find(w), _rigidGroups.size()).first;
+        if(it->second == _rigidGroups.size()) _rigidGroups.emplace_back();
+
+        _rigidGroupOf[w] = it->second;
+        _rigidGroups[it->second].push_back(w);
+    }
+
+    _preferenceCosts.resize(_inputData->max_preference() + 1);
+    for(int pref = 0; pref <= _inputData->max_preference(); pref++)
+    {
+        _preferenceCosts[pref] = pow(pref + 1.0, _options->preference_exponent());
+    }
 }
 
 int HillClimbingSolver::assignment_count() const
@@ -101,6 +435,11 @@ int HillClimbingSolver::assignment_count() const
     return _assignmentCount;
 }
 
+int HillClimbingSolver::pruned_count() const
+{
+    return _prunedCount;
+}
+
 Solution HillClimbingSolver::solve(const_ptr<Scheduling> const& scheduling)
 {
     Solution bestSolution(scheduling, solve_assignment(scheduling));
@@ -111,12 +450,24 @@ Solution HillClimbingSolver::solve(const_ptr<Scheduling> const& scheduling)
         return Solution::invalid();
     }
 
+    // The dual values have to be taken right after the assignment was solved, since every solve replaces them.
+    //
+    auto bestSlotDuals = _assignmentSolver.slot_duals(*bestSolution.assignment());
+
     while(true)
     {
         bool foundBetterNeighbor = false;
-        for(auto const& neighbor : pick_neighbors(bestSolution.scheduling()))
+        auto parent = bestSolution.scheduling();
+        int parentBottleneck = bestSolution.assignment()->max_used_preference();
+        for(auto const& neighbor : pick_neighbors(parent, bestSolution.assignment(), bestSlotDuals))
         {
-            Solution neighborSolution(neighbor, solve_assignment(neighbor));
+            if(!(_scoring->lower_bound(*neighbor) < bestScore))
+            {
+                _prunedCount++;
+                continue;
+            }
+
+            Solution neighborSolution(neighbor, solve_assignment(neighbor, parent, parentBottleneck));
 
             if(is_set(_cancellation)) return Solution::invalid();
 
@@ -127,6 +478,7 @@ Solution HillClimbingSolver::solve(const_ptr<Scheduling> const& scheduling)
                 foundBetterNeighbor = true;
                 bestScore = neighborScore;
                 bestSolution = neighborSolution;
+                bestSlotDuals = _assignmentSolver.slot_duals(*bestSolution.assignment());
             }
         }
 
@@ -24,6 +24,7 @@
 #include "CriticalSetAnalysis.h"
 #include "Scoring.h"
 #include "AssignmentSolver.h"
+#include "AssignmentCache.h"
 
 #include <future>
 
@@ -41,54 +42,133 @@ private:
     const_ptr<Scoring> _scoring;
     const_ptr<Options> _options;
     cancel_token _cancellation;
+    shared_ptr<AssignmentCache> _assignmentCache;
 
     int _assignmentCount = 0;
+    int _prunedCount = 0;
+    vector<double> _preferenceCosts;
+    vector<int> _rigidGroupOf;
+    vector<vector<int>> _rigidGroups;
 
     AssignmentSolver _assignmentSolver;
 
     /**
-     * The maximum number of possible mutations is also the maximum neighbor key.
+     * A move of the scheduling neighborhood, given as pairs of a choice and its new slot. The other choices of the
+     * rigid group of each moved choice (choices tied to it by ChoicesHaveOffset or ChoicesAreInSameSlot constraints)
+     * are moved by the same number of slots, so such chains stay intact.
+     */
+    using Move = vector<pair<int, int>>;
+
+    /**
+     * The maximum number of possible relocations (moves of a single choice to another slot) is also the maximum
+     * neighbor key.
      */
     int max_neighbor_key();
 
     /**
-     * Solves the assignment for a given scheduling using the assignment solver.
+     * Returns the relocation determined by the neighbor key (between 0 and max_neighbor_key).
+     */
+    Move relocation_move(shared_ptr<Scheduling const> const& scheduling, int neighborKey);
+
+    /**
+     * Returns a random swap move, exchanging the slots of two choices (and their rigid groups), or an empty move if the
+     * sampled choices are in the same slot. Only the given leaders (first choices of rigid groups) are sampled.
      */
-    shared_ptr<Assignment const> solve_assignment(const_ptr<Scheduling const> const& scheduling);
+    Move sample_swap_move(shared_ptr<Scheduling const> const& scheduling, vector<int> const& leaders);
 
     /**
-     * Returns a single neighbor (a scheduling differing by a single workshop-slot-assignment) of the given scheduling.
-     * Which neighbor is determined by the neighbor key (between 0 and max_neighbor_key). Note that neighbors do not
-     * have to necessarily be valid schedulings.
+     * Returns a random ejection chain of three choices in different slots, each moved to the slot of the next one (and
+     * the last one to the slot of the first one), or an empty move if the sampled choices are not in different slots.
+     * Only the given leaders (first choices of rigid groups) are sampled.
      */
-    shared_ptr<Scheduling const> neighbor(shared_ptr<Scheduling const> const& scheduling, int neighborKey);
+    Move sample_chain_move(shared_ptr<Scheduling const> const& scheduling, vector<int> const& leaders);
 
     /**
-     * Returns a list of valid neighbors for the given scheduling.
+     * Solves the assignment for a given scheduling using the assignment solver. If the scheduling is a neighbor of
+     * another scheduling, the latter should be given as the parent so the assignment can be solved incrementally. If
+     * the scheduling was already solved before (by this or any other instance sharing the assignment cache), the cached
+     * assignment is returned instead. The maximum used preference of the parent's assignment may be given as a hint
+     * for the preference limit search. Returns nullptr if the assignment solver was interrupted.
      */
-    vector<shared_ptr<Scheduling const>> pick_neighbors(shared_ptr<Scheduling const> const& scheduling);
+    shared_ptr<Assignment const> solve_assignment(const_ptr<Scheduling const> const& scheduling,
+                                                  const_ptr<Scheduling const> const& parent = nullptr,
+                                                  int preferenceLimitHint = -1);
+
+    /**
+     * Returns the neighbor of the given scheduling resulting from the given move. Returns nullptr if this would move a
+     * choice out of the slot range. Note that neighbors do not have to necessarily be valid schedulings.
+     */
+    shared_ptr<Scheduling const> neighbor(shared_ptr<Scheduling const> const& scheduling, Move const& move);
+
+    /**
+     * Checks the scheduling constraints of the given moved choices on the given neighbor scheduling. All other
+     * constraints are assumed to be unaffected by the move. The slot sizes (number of choices per slot) of the neighbor
+     * have to be given for SlotHasLimitedSize constraints.
+     */
+    bool satisfies_moved_constraints(Scheduling const& neighbor,
+                                     vector<int> const& movedChoices,
+                                     vector<int> const& slotSizes);
 
 public:
     /**
      * Constructor.
+     *
+     * @param assignmentCache An optional assignment cache that may be shared with other instances.
+     * @param threadBudget An optional thread budget that may be shared with other instances.
      */
     HillClimbingSolver(const_ptr<InputData> inputData,
                        const_ptr<CriticalSetAnalysis> csAnalysis,
                        const_ptr<MipFlowStaticData> staticData,
                        const_ptr<Scoring> scoring,
                        const_ptr<Options> options,
-                       cancel_token cancellation = cancel_token());
+                       cancel_token cancellation = cancel_token(),
+                       shared_ptr<AssignmentCache> assignmentCache = nullptr,
+                       shared_ptr<ThreadBudget> threadBudget = nullptr);
 
     /**
      * Returns the number of times the assignment solver was invoked by this instance so far.
      */
     [[nodiscard]] int assignment_count() const;
 
+    /**
+     * Returns the number of neighbors that were skipped without solving their assignment because the lower bound of
+     * their score was already not better than the current best score.
+     */
+    [[nodiscard]] int pruned_count() const;
+
     /**
      * Returns the number of linear programming instances solved by the assignment solver of this instance so far.
      */
     [[nodiscard]] int lp_count() const;
 
+    /**
+     * Returns all relocation neighbor keys of the given scheduling, ordered by the estimated improvement of the
+     * neighbor. A choice moved to another slot gains the choosers of that slot with the most negative reduced cost for
+     * it (up to its maximum), and loses the lowest reduced cost of another choice in its old slot for each of its
+     * current choosers. The reduced costs c(p, w) - d(p) + d(w) are calculated from the dual values d of the slot
+     * instances of the given assignment (see AssignmentSolver::slot_duals).
+     *
+     * If no dual values are given (the CBC and CP-SAT backends do not provide them, and assignments with edge groups
+     * are not solved slot by slot), a heuristic fallback uses the plain edge costs instead, which ignores the choice
+     * bounds of the other choices.
+     */
+    vector<int> guided_neighbor_keys(
+            shared_ptr<Scheduling const> const& scheduling,
+            shared_ptr<Assignment const> const& assignment,
+            vector<const_ptr<AssignmentSolver::SlotDuals const>> const& slotDuals = {});
+
+    /**
+     * Returns a list of valid neighbors for the given scheduling. Relocations are interleaved with randomly sampled swap
+     * and ejection chain moves, which keep the slot sizes balanced and therefore stay feasible when slots are tight. If
+     * there are not more relocations than the neighbor limit, all of them are returned before any compound move. If
+     * guided neighbors are enabled and the assignment of the scheduling is given, the relocations are ordered by their
+     * estimated improvement (see guided_neighbor_keys); otherwise, random relocations are returned.
+     */
+    vector<shared_ptr<Scheduling const>> pick_neighbors(
+            shared_ptr<Scheduling const> const& scheduling,
+            shared_ptr<Assignment const> const& assignment = nullptr,
+            vector<const_ptr<AssignmentSolver::SlotDuals const>> const& slotDuals = {});
+
     /**
      * Performs hill climbing on the given scheduling and returns the resulting solution.
      */
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaxFlow.h"
+
+#include <climits>
+
+MaxFlow::MaxFlow(int nodeCount, int source, int sink)
+        : _source(source), _sink(sink), _graph(nodeCount), _potential(nodeCount, 0)
+{
+}
+
+int MaxFlow::add_edge(int fromNode, int toNode, int capacity)
+{
+    return _graph.add_edge(fromNode, toNode, capacity);
+}
+
+int MaxFlow::augment()
+{
+    _flow += _graph.augment(_source, _sink, INT_MAX - _flow, _potential);
+    return _flow;
+}
+
+int MaxFlow::flow(int edge) const
+{
+    return _graph.flow(edge);
+}
+
+int MaxFlow::total_flow() const
+{
+    return _flow;
+}
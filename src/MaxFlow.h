@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "ResidualGraph.h"
+
+/**
+ * A native solver for integral maximum flow problems, implemented with Dinic's algorithm. Edges may be added after a
+ * call to augment; the next call then continues with the existing flow, so a sequence of growing instances can be
+ * solved with the effort of a single maximum flow computation.
+ */
+class MaxFlow
+{
+private:
+    int _source;
+    int _sink;
+    int _flow = 0;
+    ResidualGraph _graph;
+
+    /**
+     * All edges have zero cost, so zero potentials make all arcs with residual capacity admissible.
+     */
+    vector<long> _potential;
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param nodeCount The number of nodes of this instance.
+     * @param source The source node.
+     * @param sink The sink node.
+     */
+    MaxFlow(int nodeCount, int source, int sink);
+
+    /**
+     * Adds a single edge and returns its index.
+     */
+    int add_edge(int fromNode, int toNode, int capacity);
+
+    /**
+     * Increases the flow from the source to the sink as far as possible and returns the resulting total flow.
+     */
+    int augment();
+
+    /**
+     * Returns the flow of the given edge.
+     */
+    [[nodiscard]] int flow(int edge) const;
+
+    /**
+     * Returns the total flow from the source to the sink.
+     */
+    [[nodiscard]] int total_flow() const;
+};
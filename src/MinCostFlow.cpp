@@ -0,0 +1,228 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MinCostFlow.h"
+
+#include <queue>
+#include <climits>
+#include <functional>
+
+MinCostFlow::MinCostFlow(int nodeCount)
+        : _nodeCount(nodeCount), _graph(nodeCount), _supply(nodeCount, 0)
+{
+}
+
+void MinCostFlow::set_supply(int node, int supply)
+{
+    _supply[node] = supply;
+}
+
+int MinCostFlow::add_edge(int fromNode, int toNode, int capacity, long unitCost)
+{
+    if(_solved)
+    {
+        reset();
+    }
+
+    _graph.add_edge(fromNode, toNode, capacity, unitCost);
+    _capacity.push_back(capacity);
+    _capacity.push_back(0);
+
+    return _edgeCount++;
+}
+
+void MinCostFlow::reset()
+{
+    _solved = false;
+    _graph.resize(_nodeCount, 2 * _edgeCount);
+
+    for(int arc = 0; arc < _graph.arc_count(); arc++)
+    {
+        _graph.arc(arc).capacity = _capacity[arc];
+    }
+}
+
+bool MinCostFlow::update_potentials(int source, int sink)
+{
+    const long infinity = LONG_MAX / 4;
+
+    vector<long> distance(_graph.node_count(), infinity);
+    std::priority_queue<pair<long, int>, vector<pair<long, int>>, std::greater<>> queue;
+
+    distance[source] = 0;
+    queue.push({0, source});
+
+    while(!queue.empty())
+    {
+        auto [dist, node] = queue.top();
+        queue.pop();
+
+        if(dist > distance[node]) continue;
+
+        for(int arcIdx : _graph.adjacent(node))
+        {
+            Arc const& arc = _graph.arc(arcIdx);
+            if(arc.capacity <= 0) continue;
+
+            long next = dist + arc.cost + _potential[node] - _potential[arc.to];
+            if(next < distance[arc.to])
+            {
+                distance[arc.to] = next;
+                queue.push({next, arc.to});
+            }
+        }
+    }
+
+    if(distance[sink] >= infinity)
+    {
+        return false;
+    }
+
+    // Clamping the distances at the sink distance keeps all reduced costs non-negative, even for nodes that are not
+    // reachable anymore.
+    //
+    for(int node = 0; node < _graph.node_count(); node++)
+    {
+        _potential[node] += std::min(distance[node], distance[sink]);
+    }
+
+    return true;
+}
+
+bool MinCostFlow::solve()
+{
+    reset();
+    _solved = true;
+
+    // We reduce the supplies to a single source and a single sink by adding two extra nodes.
+    //
+    int source = _nodeCount;
+    int sink = _nodeCount + 1;
+    _graph.resize(_nodeCount + 2, _graph.arc_count());
+
+    int required = 0;
+    int absorbed = 0;
+    for(int node = 0; node < _nodeCount; node++)
+    {
+        if(_supply[node] == 0) continue;
+
+        if(_supply[node] > 0)
+        {
+            _graph.add_edge(source, node, _supply[node]);
+            required += _supply[node];
+        }
+        else
+        {
+            _graph.add_edge(node, sink, -_supply[node]);
+            absorbed += -_supply[node];
+        }
+    }
+
+    if(required != absorbed)
+    {
+        return false;
+    }
+
+    _potential.assign(_graph.node_count(), 0);
+
+    // Negative costs would invalidate the initial zero potentials, so we compute proper ones with Bellman-Ford first.
+    //
+    bool hasNegativeCosts = false;
+    for(int arc = 0; arc < 2 * _edgeCount; arc += 2)
+    {
+        hasNegativeCosts |= _graph.arc(arc).cost < 0 && _graph.arc(arc).capacity > 0;
+    }
+
+    if(hasNegativeCosts)
+    {
+        const long infinity = LONG_MAX / 4;
+        std::fill(_potential.begin(), _potential.end(), infinity);
+        _potential[source] = 0;
+
+        for(int round = 0; round < _graph.node_count(); round++)
+        {
+            bool changed = false;
+            for(int node = 0; node < _graph.node_count(); node++)
+            {
+                if(_potential[node] >= infinity) continue;
+                for(int arcIdx : _graph.adjacent(node))
+                {
+                    Arc const& arc = _graph.arc(arcIdx);
+                    if(arc.capacity > 0 && _potential[node] + arc.cost < _potential[arc.to])
+                    {
+                        _potential[arc.to] = _potential[node] + arc.cost;
+                        changed = true;
+                    }
+                }
+            }
+
+            if(!changed) break;
+        }
+
+        for(long& potential : _potential)
+        {
+            if(potential >= infinity) potential = 0;
+        }
+    }
+
+    // All shortest paths of the same length are augmented at once with a blocking flow on the arcs with zero reduced
+    // cost.
+    //
+    int flow = 0;
+    while(flow < required && update_potentials(source, sink))
+    {
+        int pushed = _graph.augment(source, sink, required - flow, _potential);
+
+        // Without negative cycles, every shortest path phase augments at least one unit.
+        //
+        if(pushed == 0) break;
+
+        flow += pushed;
+    }
+
+    return flow == required;
+}
+
+int MinCostFlow::flow(int edge) const
+{
+    return _graph.flow(edge);
+}
+
+long MinCostFlow::potential(int node) const
+{
+    return _potential[node];
+}
+
+long MinCostFlow::total_cost() const
+{
+    long cost = 0;
+    for(int edge = 0; edge < _edgeCount; edge++)
+    {
+        cost += flow(edge) * _graph.arc(2 * edge).cost;
+    }
+
+    return cost;
+}
+
+int MinCostFlow::node_count() const
+{
+    return _nodeCount;
+}
+
+int MinCostFlow::edge_count() const
+{
+    return _edgeCount;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Types.h"
+#include "ResidualGraph.h"
+
+/**
+ * A native solver for integral min-cost-flow problems. This is used instead of the MIP solver for flow instances that
+ * do not need any additional side constraints, because those can be solved a lot faster with a combinatorial algorithm.
+ *
+ * The implemented algorithm is the primal-dual method: Shortest augmenting paths are found with Dijkstra's algorithm
+ * using node potentials, and all shortest paths of the same length are then augmented at once with a blocking flow.
+ */
+class MinCostFlow
+{
+private:
+    using Arc = ResidualGraph::Arc;
+
+    int _nodeCount;
+    int _edgeCount = 0;
+    bool _solved = false;
+    ResidualGraph _graph;
+    vector<int> _capacity;
+    vector<int> _supply;
+    vector<long> _potential;
+
+    /**
+     * Calculates the shortest path distances from the source with respect to the reduced costs and adds them to the
+     * node potentials. Returns false if the sink is not reachable.
+     */
+    bool update_potentials(int source, int sink);
+
+    /**
+     * Removes the arcs and nodes added by the last call to solve and restores all residual capacities.
+     */
+    void reset();
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param nodeCount The number of nodes of this instance.
+     */
+    explicit MinCostFlow(int nodeCount);
+
+    /**
+     * Set the (possibly negative) supply of a single node.
+     */
+    void set_supply(int node, int supply);
+
+    /**
+     * Adds a single edge and returns its index.
+     */
+    int add_edge(int fromNode, int toNode, int capacity, long unitCost);
+
+    /**
+     * Solves this instance. Returns false if there is no flow satisfying all supplies. The instance must not contain
+     * any negative cost cycles.
+     */
+    bool solve();
+
+    /**
+     * Returns the flow of the given edge in the last solution.
+     */
+    [[nodiscard]] int flow(int edge) const;
+
+    /**
+     * Returns the potential of the given node in the last solution. The reduced cost (the unit cost plus the potential
+     * of the start node minus the potential of the end node) of every edge is non-negative if the edge is not
+     * saturated and non-positive if it carries flow.
+     */
+    [[nodiscard]] long potential(int node) const;
+
+    /**
+     * Returns the total cost of the last solution.
+     */
+    [[nodiscard]] long total_cost() const;
+
+    /**
+     * Returns the number of nodes in this instance.
+     */
+    [[nodiscard]] int node_count() const;
+
+    /**
+     * Returns the number of edges in this instance.
+     */
+    [[nodiscard]] int edge_count() const;
+};
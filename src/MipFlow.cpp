@@ -0,0 +1,695 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MipFlow.h"
+
+#include "Util.h"
+#include "UnionFind.h"
+
+#include <climits>
+#include <algorithm>
+
+int MipFlow::add_node()
+{
+    invalidate_model();
+    _csrValid = false;
+    _supply.push_back(0);
+    return node_count() - 1;
+}
+
+void MipFlow::set_supply(int node, int supply)
+{
+    invalidate_model();
+    _supply[node] = supply;
+}
+
+int MipFlow::add_edge(int fromNode, int toNode, int max, long unitCost)
+{
+    invalidate_model();
+    _csrValid = false;
+    _edgesFrom.push_back(fromNode);
+    _edgesTo.push_back(toNode);
+    _edgesMax.push_back(max);
+    _edgesCost.push_back(unitCost);
+
+    return edge_count() - 1;
+}
+
+void MipFlow::invalidate_model()
+{
+    _solution.clear();
+    _modelSolver = nullptr;
+    _modelId = -1;
+    _variables.clear();
+    _changedEdges.clear();
+}
+
+void MipFlow::set_edge_max(int edge, int max)
+{
+    if(_edgesMax[edge] == max) return;
+
+    _solution.clear();
+    _edgesMax[edge] = max;
+    _changedEdges.push_back(edge);
+}
+
+void MipFlow::set_edge_cost(int edge, long unitCost)
+{
+    if(_edgesCost[edge] == unitCost) return;
+
+    _solution.clear();
+    _edgesCost[edge] = unitCost;
+    _changedEdges.push_back(edge);
+}
+
+void MipFlow::create_edge_group_or_block_edges(vector<int> const& edges)
+{
+    invalidate_model();
+
+    vector<int> existingEdges;
+    bool blocked = false;
+
+    for(int edge : edges)
+    {
+        if(edge < 0)
+        {
+            blocked = true;
+        }
+        else
+        {
+            existingEdges.push_back(edge);
+        }
+    }
+
+    if(blocked)
+    {
+        for(int edge : existingEdges)
+        {
+            _blockedEdges.push_back(edge);
+        }
+    }
+    else
+    {
+        _edgeGroups.push_back(existingEdges);
+    }
+}
+
+void MipFlow::build_csr()
+{
+    if(_csrValid) return;
+
+    _outgoingStart.assign(node_count() + 1, 0);
+    _incomingStart.assign(node_count() + 1, 0);
+
+    for(int i = 0; i < edge_count(); i++)
+    {
+        _outgoingStart[_edgesFrom[i] + 1]++;
+        _incomingStart[_edgesTo[i] + 1]++;
+    }
+
+    for(int i = 0; i < node_count(); i++)
+    {
+        _outgoingStart[i + 1] += _outgoingStart[i];
+        _incomingStart[i + 1] += _incomingStart[i];
+    }
+
+    _outgoing.resize(edge_count());
+    _incoming.resize(edge_count());
+
+    vector<int> outgoingPos(_outgoingStart.begin(), _outgoingStart.end() - 1);
+    vector<int> incomingPos(_incomingStart.begin(), _incomingStart.end() - 1);
+
+    for(int i = 0; i < edge_count(); i++)
+    {
+        _outgoing[outgoingPos[_edgesFrom[i]]++] = i;
+        _incoming[incomingPos[_edgesTo[i]]++] = i;
+    }
+
+    _csrValid = true;
+}
+
+bool MipFlow::solve_native()
+{
+    MinCostFlow minCostFlow(node_count());
+
+    for(int i = 0; i < node_count(); i++)
+    {
+        minCostFlow.set_supply(i, _supply[i]);
+    }
+
+    vector<int> edgesMax(_edgesMax);
+    for(int edge : _blockedEdges)
+    {
+        edgesMax[edge] = 0;
+    }
+
+    // MinCostFlow assigns edge indexes in insertion order, so the edge indexes of both instances are the same.
+    //
+    for(int i = 0; i < edge_count(); i++)
+    {
+        minCostFlow.add_edge(_edgesFrom[i], _edgesTo[i], edgesMax[i], _edgesCost[i]);
+    }
+
+    if(!minCostFlow.solve())
+    {
+        return false;
+    }
+
+    _solution.clear();
+    _solution.resize(edge_count());
+
+    for(int i = 0; i < edge_count(); i++)
+    {
+        _solution[i] = minCostFlow.flow(i);
+    }
+
+    // The potentials of the min cost flow solver are the negated dual values.
+    //
+    _dualValues.resize(node_count());
+    for(int i = 0; i < node_count(); i++)
+    {
+        _dualValues[i] = -minCostFlow.potential(i);
+    }
+
+    return true;
+}
+
+void MipFlow::presolve()
+{
+    build_csr();
+
+    // All edges of (possibly overlapping) edge groups have the same flow, so they share a single variable. An edge
+    // group containing a blocked edge gets no variable at all.
+    //
+    UnionFind<int> edgeClasses(edge_count());
+    vector<bool> grouped(edge_count(), false);
+
+    for(vector<int> const& group : _edgeGroups)
+    {
+        for(int edge : group)
+        {
+            edgeClasses.join(group.front(), edge);
+            grouped[edge] = true;
+        }
+    }
+
+    vector<bool> blockedClasses(edge_count(), false);
+    for(int edge : _blockedEdges)
+    {
+        blockedClasses[edgeClasses.find(edge)] = true;
+    }
+
+    auto isRemoved = [&](int edge)
+    {
+        return blockedClasses[edgeClasses.find(edge)] || _fixedFlow[edge] > 0;
+    };
+
+    // A node with supply that has no incoming edges and only one outgoing edge (e.g. a chooser with a ChooserIsInChoice
+    // constraint) forces the flow of this edge. Such edges are fixed and their flow is moved to the end node.
+    //
+    _fixedFlow.assign(edge_count(), 0);
+    _fixedEdges.clear();
+    _presolvedSupply = _supply;
+
+    for(int i = 0; i < node_count(); i++)
+    {
+        if(_presolvedSupply[i] <= 0) continue;
+
+        int incomingCount = 0;
+        for(int j = _incomingStart[i]; j < _incomingStart[i + 1]; j++)
+        {
+            if(!isRemoved(_incoming[j])) incomingCount++;
+        }
+
+        int outgoingCount = 0;
+        int outgoingEdge = -1;
+        for(int j = _outgoingStart[i]; j < _outgoingStart[i + 1]; j++)
+        {
+            if(isRemoved(_outgoing[j])) continue;
+
+            outgoingCount++;
+            outgoingEdge = _outgoing[j];
+        }
+
+        if(incomingCount > 0 || outgoingCount != 1 || grouped[outgoingEdge]) continue;
+
+        _fixedFlow[outgoingEdge] = _presolvedSupply[i];
+        _fixedEdges.push_back(outgoingEdge);
+        _presolvedSupply[_edgesTo[outgoingEdge]] += _presolvedSupply[i];
+        _presolvedSupply[i] = 0;
+    }
+
+    // Every remaining edge class becomes a single variable.
+    //
+    _edgeVariable.assign(edge_count(), -1);
+    _variableEdges.clear();
+    _variableIntegral.clear();
+
+    vector<int> classVariables(edge_count(), -1);
+    for(int i = 0; i < edge_count(); i++)
+    {
+        if(isRemoved(i)) continue;
+
+        int edgeClass = edgeClasses.find(i);
+        if(classVariables[edgeClass] < 0)
+        {
+            classVariables[edgeClass] = _variableEdges.size();
+            _variableEdges.emplace_back();
+            _variableIntegral.push_back(grouped[i]);
+        }
+
+        _edgeVariable[i] = classVariables[edgeClass];
+        _variableEdges[classVariables[edgeClass]].push_back(i);
+    }
+}
+
+pair<int, long> MipFlow::variable_max_and_cost(int variable) const
+{
+    int max = INT_MAX;
+    long cost = 0;
+
+    for(int edge : _variableEdges[variable])
+    {
+        max = std::min(max, _edgesMax[edge]);
+        cost += _edgesCost[edge];
+    }
+
+    return std::make_pair(max, cost);
+}
+
+void MipFlow::update_variable(int variable)
+{
+    auto [max, cost] = variable_max_and_cost(variable);
+
+    _variables[variable]->SetUB(max);
+    _modelSolver->MutableObjective()->SetCoefficient(_variables[variable], cost);
+}
+
+void MipFlow::build_model(MipSolver& mipSolver)
+{
+    presolve();
+
+    // The model is filled into a proto and loaded in one call, which is much faster than creating every variable and
+    // coefficient through the solver. Variables and constraints stay unnamed.
+    //
+    op::MPModelProto model;
+    _modelInfeasible = false;
+
+    // Only the edge group variables have to be integral; the other ones are integral in every optimal vertex anyway.
+    // CP-SAT can only handle continuous variables by scaling them, though, so all variables are integral for it.
+    //
+    bool allIntegral = mipSolver.get().ProblemType() == op::MPSolver::SAT_INTEGER_PROGRAMMING;
+
+    for(int i = 0; i < _variableEdges.size(); i++)
+    {
+        auto [max, cost] = variable_max_and_cost(i);
+
+        op::MPVariableProto* variable = model.add_variable();
+        variable->set_lower_bound(0);
+        variable->set_upper_bound(max);
+        variable->set_objective_coefficient(cost);
+        variable->set_is_integer(allIntegral || _variableIntegral[i]);
+    }
+
+    // The node constraints are built from the variables instead of the edges, so an edge group shows up with the sum of
+    // its coefficients. Rows that are equal to another row (like the rows of two choosers that have the same choices)
+    // are only added once. Rows are looked up by a hash; on a hash match, the row is compared with the constraint that
+    // was already added.
+    //
+    std::unordered_multimap<size_t, int> constraintsByHash;
+    _nodeConstraints.assign(node_count(), -1);
+
+    for(int i = 0; i < node_count(); i++)
+    {
+        vector<pair<int, int>> coefficients;
+        for(int j = _incomingStart[i]; j < _incomingStart[i + 1]; j++)
+        {
+            if(_edgeVariable[_incoming[j]] >= 0) coefficients.emplace_back(_edgeVariable[_incoming[j]], 1);
+        }
+
+        for(int j = _outgoingStart[i]; j < _outgoingStart[i + 1]; j++)
+        {
+            if(_edgeVariable[_outgoing[j]] >= 0) coefficients.emplace_back(_edgeVariable[_outgoing[j]], -1);
+        }
+
+        std::sort(coefficients.begin(), coefficients.end());
+
+        vector<pair<int, int>> row;
+        for(auto const& coefficient : coefficients)
+        {
+            if(!row.empty() && row.back().first == coefficient.first)
+            {
+                row.back().second += coefficient.second;
+            }
+            else
+            {
+                row.push_back(coefficient);
+            }
+        }
+
+        row.erase(std::remove_if(row.begin(), row.end(), [](auto const& c) { return c.second == 0; }), row.end());
+
+        if(row.empty())
+        {
+            if(_presolvedSupply[i] != 0) _modelInfeasible = true;
+            continue;
+        }
+
+        size_t hash = -_presolvedSupply[i];
+        for(auto const& coefficient : row)
+        {
+            hash = hash * 31 + std::hash<pair<int, int>>()(coefficient);
+        }
+
+        auto [first, last] = constraintsByHash.equal_range(hash);
+        bool duplicate = std::any_of(first, last, [&](auto const& entry)
+        {
+            op::MPConstraintProto const& other = model.constraint(entry.second);
+            if(other.lower_bound() != -_presolvedSupply[i] || other.var_index_size() != row.size()) return false;
+
+            for(int j = 0; j < row.size(); j++)
+            {
+                if(other.var_index(j) != row[j].first || other.coefficient(j) != row[j].second) return false;
+            }
+
+            return true;
+        });
+
+        if(duplicate) continue;
+        constraintsByHash.emplace(hash, model.constraint_size());
+        _nodeConstraints[i] = model.constraint_size();
+
+        op::MPConstraintProto* nodeConst = model.add_constraint();
+        nodeConst->set_lower_bound(-_presolvedSupply[i]);
+        nodeConst->set_upper_bound(-_presolvedSupply[i]);
+        for(auto const& coefficient : row)
+        {
+            nodeConst->add_var_index(coefficient.first);
+            nodeConst->add_coefficient(coefficient.second);
+        }
+    }
+
+    model.set_maximize(false);
+
+    op::MPSolver& solver = mipSolver.get();
+    _modelId = mipSolver.load_model();
+
+    string error;
+    if(solver.LoadModelFromProto(model, &error) != op::MPSOLVER_MODEL_IS_VALID)
+    {
+        throw std::logic_error("Could not load the MIP model: " + error);
+    }
+
+    _variables = solver.variables();
+    _modelSolver = &solver;
+    _changedEdges.clear();
+}
+
+MipSolver::MipSolver(op::MPSolver::OptimizationProblemType problemType)
+        : _solver("solver", problemType)
+{
+}
+
+MipSolver::~MipSolver()
+{
+    {
+        std::lock_guard lock(_watcherMutex);
+        _stopWatcher = true;
+    }
+
+    _watcherCondition.notify_all();
+    if(_watcher.joinable())
+    {
+        _watcher.join();
+    }
+}
+
+void MipSolver::set_time_limit(long timeLimitMillis, optional<datetime> deadline)
+{
+    _timeLimitMillis = timeLimitMillis;
+    _deadline = deadline;
+
+    if(_timeLimitMillis > 0)
+    {
+        _solver.set_time_limit(_timeLimitMillis);
+    }
+}
+
+op::MPSolver::ResultStatus MipSolver::solve(cancel_token const& cancellation)
+{
+    // Some solvers (like CBC) cannot be interrupted, so a cancelled solve would run until its own time limit. Until
+    // an interruption worked, the time limit is clamped to the time remaining until the deadline instead.
+    //
+    if(!_interruptSupported && _deadline.has_value())
+    {
+        auto remaining = std::max(1L, (long)std::chrono::duration_cast<milliseconds>(*_deadline - time_now()).count());
+        _solver.set_time_limit(_timeLimitMillis > 0 ? std::min(_timeLimitMillis, remaining) : remaining);
+    }
+
+    if(!cancellation.valid())
+    {
+        return _solver.Solve();
+    }
+
+    {
+        std::lock_guard lock(_watcherMutex);
+        if(!_watcher.joinable())
+        {
+            _watcher = std::thread([this] { watch(); });
+        }
+
+        _watchedCancellation = cancellation;
+        _solving = true;
+        _solveCount++;
+    }
+
+    _watcherCondition.notify_all();
+    auto status = _solver.Solve();
+
+    {
+        std::lock_guard lock(_watcherMutex);
+        _solving = false;
+        _watchedCancellation = {};
+    }
+
+    _watcherCondition.notify_all();
+    return status;
+}
+
+void MipSolver::watch()
+{
+    std::unique_lock lock(_watcherMutex);
+    long interruptedSolve = 0;
+
+    while(!_stopWatcher)
+    {
+        // Sleep until a solve starts that was not interrupted yet.
+        //
+        if(!_solving || interruptedSolve == _solveCount)
+        {
+            _watcherCondition.wait(lock, [&] { return _stopWatcher || (_solving && interruptedSolve != _solveCount); });
+            continue;
+        }
+
+        if(is_set(_watchedCancellation))
+        {
+            if(_solver.InterruptSolve()) _interruptSupported = true;
+            interruptedSolve = _solveCount;
+            continue;
+        }
+
+        _watcherCondition.wait_for(lock, milliseconds(10), [&] { return _stopWatcher || !_solving; });
+    }
+}
+
+op::MPSolver& MipSolver::get()
+{
+    return _solver;
+}
+
+long MipSolver::load_model()
+{
+    _modelId = NextModelId++;
+    return _modelId;
+}
+
+long MipSolver::model_id() const
+{
+    return _modelId;
+}
+
+op::MPSolver::OptimizationProblemType MipFlow::problem_type(AssignmentBackend backend, bool edgeGroups)
+{
+    // Without edge groups, the constraint matrix of the model is the incidence matrix of the flow graph, which is
+    // totally unimodular. That is why an LP solver like GLOP also yields an integral solution in this case.
+    //
+    switch(backend)
+    {
+        case CpSatBackend: return op::MPSolver::SAT_INTEGER_PROGRAMMING;
+        case GlopBackend: return edgeGroups
+                                 ? op::MPSolver::CBC_MIXED_INTEGER_PROGRAMMING
+                                 : op::MPSolver::GLOP_LINEAR_PROGRAMMING;
+        default: return op::MPSolver::CBC_MIXED_INTEGER_PROGRAMMING;
+    }
+}
+
+bool MipFlow::is_supported(AssignmentBackend backend)
+{
+    if(backend == NativeBackend)
+    {
+        return true;
+    }
+
+    return op::MPSolver::SupportsProblemType(problem_type(backend, false))
+           && op::MPSolver::SupportsProblemType(problem_type(backend, true));
+}
+
+bool MipFlow::solve(MipSolver& mipSolver, AssignmentBackend backend, cancel_token const& cancellation)
+{
+    _dualValues.clear();
+    _interrupted = is_set(cancellation);
+    if(_interrupted)
+    {
+        return false;
+    }
+
+    if(_edgeGroups.empty() && (backend == AutoBackend || backend == NativeBackend))
+    {
+        return solve_native();
+    }
+
+    if(_modelId < 0 || mipSolver.model_id() != _modelId)
+    {
+        build_model(mipSolver);
+    }
+    else
+    {
+        // The model is still loaded in the solver, so we only have to update the variables of the edges that changed
+        // since the last solve.
+        //
+        for(int edge : _changedEdges)
+        {
+            if(_edgeVariable[edge] >= 0) update_variable(_edgeVariable[edge]);
+        }
+
+        _changedEdges.clear();
+    }
+
+    if(_modelInfeasible)
+    {
+        return false;
+    }
+
+    for(int edge : _fixedEdges)
+    {
+        if(_edgesMax[edge] < _fixedFlow[edge]) return false;
+    }
+
+    auto status = mipSolver.solve(cancellation);
+    if(status != op::MPSolver::OPTIMAL)
+    {
+        _interrupted = status == op::MPSolver::NOT_SOLVED
+                       || status == op::MPSolver::FEASIBLE
+                       || (status != op::MPSolver::INFEASIBLE && is_set(cancellation));
+        return false;
+    }
+
+    // Map the solution of the presolved model back to the edges.
+    //
+    _solution.assign(_fixedFlow.begin(), _fixedFlow.end());
+    for(int i = 0; i < edge_count(); i++)
+    {
+        if(_edgeVariable[i] >= 0) _solution[i] = (int)round(_variables[_edgeVariable[i]]->solution_value());
+    }
+
+    // Only an LP solver provides dual values. The node constraints are built as inflow minus outflow, so their dual
+    // values are negated. A node without a constraint either has no edges left or has its flow forced through a fixed
+    // edge, whose reduced cost is zero then. Fixed edges are handled backwards, because the end node of a fixed edge
+    // can only be the start node of an edge fixed after it.
+    //
+    if(mipSolver.get().ProblemType() == op::MPSolver::GLOP_LINEAR_PROGRAMMING)
+    {
+        auto const& constraints = mipSolver.get().constraints();
+        _dualValues.assign(node_count(), 0);
+
+        for(int i = 0; i < node_count(); i++)
+        {
+            if(_nodeConstraints[i] >= 0) _dualValues[i] = -constraints[_nodeConstraints[i]]->dual_value();
+        }
+
+        for(auto it = _fixedEdges.rbegin(); it != _fixedEdges.rend(); it++)
+        {
+            _dualValues[_edgesFrom[*it]] = _edgesCost[*it] + _dualValues[_edgesTo[*it]];
+        }
+    }
+
+    return true;
+}
+
+int MipFlow::solution_value_at(int edge) const
+{
+    if(_solution.empty())
+    {
+        throw std::logic_error("The MIP flow instance is not solved.");
+    }
+
+    return _solution[edge];
+}
+
+bool MipFlow::interrupted() const
+{
+    return _interrupted;
+}
+
+bool MipFlow::has_dual_values() const
+{
+    return !_dualValues.empty();
+}
+
+double MipFlow::dual_value(int node) const
+{
+    if(_dualValues.empty())
+    {
+        throw std::logic_error("The last solve of the MIP flow instance did not provide dual values.");
+    }
+
+    return _dualValues[node];
+}
+
+bool MipFlow::has_edge_groups() const
+{
+    return !_edgeGroups.empty();
+}
+
+int MipFlow::edge_from(int edge) const
+{
+    return _edgesFrom[edge];
+}
+
+int MipFlow::edge_to(int edge) const
+{
+    return _edgesTo[edge];
+}
+
+int MipFlow::node_count() const
+{
+    return _supply.size();
+}
+
+int MipFlow::edge_count() const
+{
+    return _edgesMax.size();
+}
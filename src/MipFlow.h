@@ -17,41 +17,175 @@
 #pragma once
 
 #include "Types.h"
+#include "Options.h"
+#include "MinCostFlow.h"
+#include "Util.h"
 
 #include <ortools/linear_solver/linear_solver.h>
+#include <ortools/linear_solver/linear_solver.pb.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace op = operations_research;
 
+/**
+ * A MIP solver together with the identity of the model currently loaded into it. Several MipFlow instances may share
+ * one solver; each of them only reuses its model if it is still the one loaded into the solver.
+ */
+class MipSolver
+{
+private:
+    /**
+     * Model ids are unique across all solvers, so a solver that happens to be allocated at the address of a destroyed
+     * one can never be mistaken for it.
+     */
+    inline static atomic<long> NextModelId = 0;
+
+    op::MPSolver _solver;
+    long _modelId = -1;
+
+    long _timeLimitMillis = 0;
+    optional<datetime> _deadline;
+    atomic<bool> _interruptSupported = false;
+
+    /**
+     * The watcher thread is started with the first cancellable solve and lives as long as this solver. It polls the
+     * cancellation token of the running solve (tokens cannot notify anyone) and sleeps while no solve is running.
+     */
+    std::thread _watcher;
+    std::mutex _watcherMutex;
+    std::condition_variable _watcherCondition;
+    cancel_token _watchedCancellation;
+    bool _solving = false;
+    long _solveCount = 0;
+    bool _stopWatcher = false;
+
+    void watch();
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit MipSolver(op::MPSolver::OptimizationProblemType problemType);
+
+    MipSolver(MipSolver const&) = delete;
+    MipSolver& operator = (MipSolver const&) = delete;
+
+    ~MipSolver();
+
+    /**
+     * Sets the time limit of a single solve (0 for none) and the point in time at which all solving has to end. The
+     * deadline only limits solves while the solver is not known to support interruption, because otherwise the
+     * cancellation token ends them in time.
+     */
+    void set_time_limit(long timeLimitMillis, optional<datetime> deadline = std::nullopt);
+
+    /**
+     * Solves the loaded model. If the given cancellation token is set while the solver runs, the solve is interrupted.
+     */
+    op::MPSolver::ResultStatus solve(cancel_token const& cancellation = {});
+
+    /**
+     * Returns the underlying solver.
+     */
+    [[nodiscard]] op::MPSolver& get();
+
+    /**
+     * Returns a new id for the model that is about to be loaded into this solver, which replaces the current one.
+     */
+    long load_model();
+
+    /**
+     * Returns the id of the model currently loaded into this solver, or -1 if there is none.
+     */
+    [[nodiscard]] long model_id() const;
+};
+
 /**
  * Contains a single assignment problem represented as a (modified) min-cost-flow problem and serves as the interface
  * for the used MIP solver.
+ *
+ * Nodes and edges are identified by their dense indexes only. The adjacency of the nodes is stored in compressed
+ * sparse row (CSR) arrays that are built once before the first solve.
  */
-template<typename NodeKey, typename EdgeKey>
 class MipFlow
 {
 private:
-    map<NodeKey, int> _nodeMap;
-    map<EdgeKey, int> _edgeMap;
     vector<int> _supply;
-    vector<vector<int>> _outgoing;
-    vector<vector<int>> _incoming;
+    vector<int> _edgesFrom;
+    vector<int> _edgesTo;
     vector<int> _edgesMax;
     vector<long> _edgesCost;
     vector<vector<int>> _edgeGroups;
     vector<int> _blockedEdges;
     vector<int> _solution;
+    vector<double> _dualValues;
 
+    bool _csrValid = false;
+    vector<int> _outgoingStart;
+    vector<int> _outgoing;
+    vector<int> _incomingStart;
+    vector<int> _incoming;
+
+    vector<int> _presolvedSupply;
+    vector<int> _fixedFlow;
+    vector<int> _fixedEdges;
+    vector<int> _edgeVariable;
+    vector<vector<int>> _variableEdges;
+    vector<bool> _variableIntegral;
+    vector<int> _nodeConstraints;
+
+    op::MPSolver* _modelSolver = nullptr;
+    long _modelId = -1;
+    bool _modelInfeasible = false;
+    bool _interrupted = false;
+    vector<op::MPVariable*> _variables;
+    vector<int> _changedEdges;
 
-public:
     /**
-     * Adds a single node.
+     * Marks the MIP model built by the last call to solve as outdated, so it will be rebuilt from scratch.
      */
-    int add_node();
+    void invalidate_model();
+
+    /**
+     * Builds the CSR adjacency arrays if they are outdated.
+     */
+    void build_csr();
+
+    /**
+     * Reduces the instance before the MIP model is built: Every edge group becomes a single shared variable, blocked
+     * edges get no variable at all and edges whose flow is forced by the supply of their start node are fixed. The
+     * mapping from edges to variables is stored, so the solution of the reduced model can be mapped back.
+     */
+    void presolve();
+
+    /**
+     * Returns the upper bound and the objective coefficient of the given variable, calculated from the edges it
+     * represents.
+     */
+    [[nodiscard]] pair<int, long> variable_max_and_cost(int variable) const;
+
+    /**
+     * Updates the bound and the objective coefficient of the given variable from the edges it represents.
+     */
+    void update_variable(int variable);
 
     /**
-     * Adds a single node with the given key.
+     * Builds the presolved MIP model of this instance in the given solver.
      */
-    int add_node(NodeKey key);
+    void build_model(MipSolver& solver);
+
+    /**
+     * Solves this instance with the native min cost flow solver. This is only possible if there are no edge groups.
+     */
+    bool solve_native();
+
+public:
+    /**
+     * Adds a single node.
+     */
+    int add_node();
 
     /**
      * Set the (possibly negative) supply of a single node.
@@ -64,37 +198,86 @@ public:
     int add_edge(int fromNode, int toNode, int max, long unitCost);
 
     /**
-     * Adds a single edge with the given key.
+     * Changes the maximum flow of a single edge. If this instance was already solved with a MIP solver, the model is
+     * kept and only the bound of the corresponding variable is updated on the next solve.
+     */
+    void set_edge_max(int edge, int max);
+
+    /**
+     * Changes the unit cost of a single edge. Just like with set_edge_max, an existing MIP model is kept and only the
+     * objective coefficient of the corresponding variable is updated on the next solve.
+     */
+    void set_edge_cost(int edge, long unitCost);
+
+    /**
+     * Creates an edge group (a set of edges that have to have the same flow). Edges that do not exist in this instance
+     * are given as -1. If some of the given edges do not exist (e.g. because they were blocked), the given edges will
+     * also be blocked instead (because they also have to have a flow of zero).
+     */
+    void create_edge_group_or_block_edges(vector<int> const& edges);
+
+    /**
+     * Returns the MIP problem type the given backend uses for instances with or without edge groups. Instances with
+     * edge groups are no plain min cost flow instances, so backends that can only solve those (the native solver and
+     * GLOP) fall back to CBC for them.
+     */
+    static op::MPSolver::OptimizationProblemType problem_type(AssignmentBackend backend, bool edgeGroups);
+
+    /**
+     * Returns true if the given backend is available in this build. The native backend is always available.
      */
-    int add_edge(EdgeKey key, int fromNode, int toNode, int max, long unitCost);
+    static bool is_supported(AssignmentBackend backend);
 
     /**
-     * Creates an edge group (a set of edges that have to have the same flow). If some of the given edges are already
-     * blocked (so they do not exist in this instance anymore), the given edges will also be blocked instead (because
-     * they also have to have a flow of zero).
+     * Solves this instance with the given backend. If there are no edge groups, this is a plain min cost flow instance
+     * and the native min cost flow solver is used for the native and auto backends. Otherwise, the given MIP solver
+     * instance (which has to have the problem type returned by problem_type) is used. Solving the same instance
+     * repeatedly with the same solver reuses the MIP model as long as only edge bounds and costs were changed and no
+     * other instance loaded its model into the solver in between.
+     *
+     * @param cancellation An optional cancellation token. If it is set while the MIP solver runs, the solve is
+     * interrupted (see interrupted).
      */
-    template<typename EdgeKeyIterator>
-    void create_edge_group_or_block_edges(EdgeKeyIterator begin, EdgeKeyIterator end);
+    bool solve(MipSolver& solver, AssignmentBackend backend = AutoBackend, cancel_token const& cancellation = {});
 
     /**
-     * Solves this instance with the given MIP solver instance.
+     * Returns true if the last solve was stopped by the cancellation token or the time limit of the MIP solver before
+     * it could prove optimality or infeasibility.
      */
-    bool solve(op::MPSolver& solver);
+    [[nodiscard]] bool interrupted() const;
+
+    /**
+     * Returns true if the last solve provided dual values. This is the case for the native min cost flow solver and for
+     * GLOP, but not for the MIP solvers.
+     */
+    [[nodiscard]] bool has_dual_values() const;
+
+    /**
+     * Returns the dual value of the flow conservation constraint of the given node in the last solution. The reduced
+     * cost of an edge (its unit cost minus the dual value of its start node plus the dual value of its end node) is
+     * non-negative if the edge can carry more flow and non-positive if it carries flow.
+     */
+    [[nodiscard]] double dual_value(int node) const;
+
+    /**
+     * Returns true if this instance contains edge groups.
+     */
+    [[nodiscard]] bool has_edge_groups() const;
 
     /**
      * Returns the flow of the given edge.
      */
-    [[nodiscard]] int solution_value_at(EdgeKey key) const;
+    [[nodiscard]] int solution_value_at(int edge) const;
 
     /**
-     * Returns the mapping between node keys and node indexes.
+     * Returns the start node of the given edge.
      */
-    [[nodiscard]] map<NodeKey, int> const& nodes() const;
+    [[nodiscard]] int edge_from(int edge) const;
 
     /**
-     * Returns the mapping between edge keys and edge indexes.
+     * Returns the end node of the given edge.
      */
-    [[nodiscard]] map<EdgeKey, int> const& edges() const;
+    [[nodiscard]] int edge_to(int edge) const;
 
     /**
      * Returns the number of nodes in this instance.
@@ -106,5 +289,3 @@ public:
      */
     [[nodiscard]] int edge_count() const;
 };
-
-#include "MipFlow.ipp"
\ No newline at end of file
@@ -17,37 +17,85 @@
 #include "MipFlowStaticData.h"
 #include "InputData.h"
 
-#define SLOT_ID_HIGH (INT_MAX / 2)
-#define CHOICE_ID_HIGH (INT_MAX / 2 - 1)
+#include <algorithm>
 
-/*
- * Some helper functions to construct node ids.
- */
-flowid MipFlowStaticData::make_long(int high, int low) { return ((flowid)high << 32U) | ((flowid)low & 0xFFFFFFFFUL); }
-flowid MipFlowStaticData::node_chooser(int p, int s) { return make_long(p, s); }
-flowid MipFlowStaticData::node_slot(int s) { return make_long(SLOT_ID_HIGH, s); }
-flowid MipFlowStaticData::node_choice(int w) { return make_long(CHOICE_ID_HIGH, w); }
-flowid MipFlowStaticData::edge_id(int from, int to) { return make_long(from, to); }
+int MipFlowStaticData::node_chooser(int p, int s) const { return chooserSlotNodes[p * _slotCount + s]; }
+int MipFlowStaticData::node_slot(int s) const { return slotNodes[s]; }
+int MipFlowStaticData::node_choice(int w) const { return choiceNodes[w]; }
 
 MipFlowStaticData::MipFlowStaticData(const_ptr<InputData> inputData)
+    : _slotCount(inputData->slot_count())
 {
+    chooserSlotNodes.resize(inputData->chooser_count() * inputData->slot_count());
     for(int p = 0; p < inputData->chooser_count(); p++)
     {
         for(int s = 0; s < inputData->slot_count(); s++)
         {
-            baseFlow.add_node(node_chooser(p, s));
+            chooserSlotNodes[p * _slotCount + s] = baseFlow.add_node();
         }
     }
 
+    choiceNodes.resize(inputData->choice_count());
     for(int w = 0; w < inputData->choice_count(); w++)
     {
-        baseFlow.add_node(node_choice(w));
+        choiceNodes[w] = baseFlow.add_node();
     }
 
+    slotNodes.resize(inputData->slot_count());
     for(int s = 0; s < inputData->slot_count(); s++)
     {
-        baseFlow.add_node(node_slot(s));
+        slotNodes[s] = baseFlow.add_node();
     }
 
     constraints = inputData->assignment_constraints();
-}
\ No newline at end of file
+
+    // Choosers with chooser-specific constraints always get a class of their own.
+    //
+    vector<bool> constrained(inputData->chooser_count(), false);
+    for(Constraint const& constraint : constraints)
+    {
+        switch(constraint.type())
+        {
+            case ChoosersHaveSameChoices:
+                constrained[constraint.right()] = true;
+                constrained[constraint.left()] = true;
+                break;
+            case ChooserIsInChoice:
+            case ChooserIsNotInChoice:
+                constrained[constraint.left()] = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    vector<int> choosers;
+    for(int p = 0; p < inputData->chooser_count(); p++)
+    {
+        if(constrained[p])
+        {
+            chooserClasses.push_back({p});
+        }
+        else
+        {
+            choosers.push_back(p);
+        }
+    }
+
+    // The unconstrained choosers are sorted by preferences, so equal preferences are adjacent.
+    //
+    std::stable_sort(choosers.begin(), choosers.end(), [&](int a, int b)
+    {
+        return inputData->chooser(a).preferences < inputData->chooser(b).preferences;
+    });
+
+    for(int i = 0; i < choosers.size(); i++)
+    {
+        if(i == 0 || inputData->chooser(choosers[i]).preferences != inputData->chooser(choosers[i - 1]).preferences)
+        {
+            chooserClasses.emplace_back();
+        }
+
+        chooserClasses.back().push_back(choosers[i]);
+    }
+}
@@ -20,27 +20,50 @@
 #include "Constraint.h"
 #include "InputData.h"
 
-typedef uint64_t flowid;
-
 /**
  * Contains some static data that is the same across all MipFlow instances and therefore do not have to be generated
  * every time.
+ *
+ * The node indexes of the base flow are stored in dense arrays, so they can be looked up without hashing.
  */
 class MipFlowStaticData
 {
 private:
-    const_ptr<InputData> _inputData;
+    int _slotCount;
 
 public:
-    MipFlow<flowid, flowid> baseFlow;
+    MipFlow baseFlow;
+    vector<int> chooserSlotNodes;
+    vector<int> choiceNodes;
+    vector<int> slotNodes;
+
+    /**
+     * Chooser-choice pairs (p, w) whose edge is always removed from the flow graph.
+     */
     vector<pair<int, int>> blockedEdges;
     vector<Constraint> constraints;
 
-    static flowid make_long(int high, int low);
-    static flowid node_chooser(int p, int s);
-    static flowid node_slot(int s);
-    static flowid node_choice(int w);
-    static flowid edge_id(int from, int to);
+    /**
+     * Equivalence classes of choosers with identical preferences that are not affected by any chooser-specific
+     * constraint. Choosers of the same class are interchangeable in every assignment without edge groups, so such
+     * flow instances only need one node per class. Every chooser is in exactly one class.
+     */
+    vector<vector<int>> chooserClasses;
+
+    /**
+     * Returns the node of chooser p in slot s.
+     */
+    [[nodiscard]] int node_chooser(int p, int s) const;
+
+    /**
+     * Returns the node of slot s.
+     */
+    [[nodiscard]] int node_slot(int s) const;
+
+    /**
+     * Returns the node of choice w.
+     */
+    [[nodiscard]] int node_choice(int w) const;
 
     explicit MipFlowStaticData(const_ptr<InputData> inputData);
 };
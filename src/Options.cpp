@@ -49,6 +49,26 @@ int Options::parse_time(string value)
     return time;
 }
 
+AssignmentBackend Options::parse_assignment_backend(string const& value)
+{
+    for(auto const& backend : _backendNames)
+    {
+        if(backend.first == value) return backend.second;
+    }
+
+    throw InputException("Unknown assignment backend " + value + ".");
+}
+
+string Options::assignment_backend_name(AssignmentBackend backend)
+{
+    for(auto const& backendName : _backendNames)
+    {
+        if(backendName.second == backend) return backendName.first;
+    }
+
+    throw std::logic_error("Unknown assignment backend.");
+}
+
 OptionsParseStatus Options::parse_base(int argc, char **argv, bool newOpt, string const& header)
 {
     OptionParser op("Allowed options");
@@ -66,6 +86,12 @@ OptionsParseStatus Options::parse_base(int argc, char **argv, bool newOpt, strin
     auto threadsOpt = op.add<Value<int>>("j", "threads", "Number of threads to use for computation.");
     auto maxNeighborsOpt = op.add<Value<int>>("n", "max-neighbors", "Maximum number of neighbor schedulings that will be explored per hill climbing iteration.");
     auto greedyOpt = op.add<Switch>("g", "greedy", "Do not use the worst-preference scoring as primary score and just use sum-based scoring instead.");
+    auto backendOpt = op.add<Value<string>>("", "assignment-backend", "The backend used to solve assignments (auto, native, cbc, cp-sat or glop).");
+    auto compareBackendsOpt = op.add<Switch>("", "compare-backends", "Report the solve times of all assignment backends on the input and exit.");
+    auto lexicographicOpt = op.add<Switch>("", "lexicographic", "Find the lowest preference limit of an assignment with one solve using lexicographic costs instead of a binary search, then solve once more at this limit. Only affects inputs with constraints that make choosers share their choices, and only works with a handful of preference levels above the preference bound.");
+    auto assignmentTimeoutOpt = op.add<Value<string>>("", "assignment-timeout", "Sets the time limit for a single assignment solve; 0 disables the limit.");
+    auto guidedNeighborsOpt = op.add<Switch>("", "guided-neighbors", "Explore the neighbor schedulings with the highest estimated improvement first instead of random ones. The estimate uses the reduced costs of the current assignment with the native and GLOP backends and a simpler preference-based estimate otherwise.");
+    auto cacheSizeOpt = op.add<Value<int>>("", "cache-size", "Maximum memory (in MiB) used to cache the assignments of already visited schedulings; 0 disables the cache.");
 
     op.parse(argc, argv);
 
@@ -105,6 +131,12 @@ OptionsParseStatus Options::parse_base(int argc, char **argv, bool newOpt, strin
         if(noCsOpt->is_set()) set_no_critical_sets(true);
         if(threadsOpt->is_set()) set_thread_count(threadsOpt->value());
         if(greedyOpt->is_set()) set_greedy(true);
+        if(cacheSizeOpt->is_set()) set_cache_size(cacheSizeOpt->value());
+        if(backendOpt->is_set()) set_assignment_backend(parse_assignment_backend(backendOpt->value()));
+        if(compareBackendsOpt->is_set()) set_compare_backends(true);
+        if(lexicographicOpt->is_set()) set_lexicographic(true);
+        if(assignmentTimeoutOpt->is_set()) set_assignment_timeout_seconds(parse_time(assignmentTimeoutOpt->value()));
+        if(guidedNeighborsOpt->is_set()) set_guided_neighbors(true);
 
         if(verbosity() > 0 && newOpt)
         {
@@ -190,6 +222,36 @@ int Options::max_neighbors() const
     return _maxNeighbors;
 }
 
+int Options::cache_size() const
+{
+    return _cacheSize;
+}
+
+AssignmentBackend Options::assignment_backend() const
+{
+    return _assignmentBackend;
+}
+
+bool Options::compare_backends() const
+{
+    return _compareBackends;
+}
+
+bool Options::lexicographic() const
+{
+    return _lexicographic;
+}
+
+int Options::assignment_timeout_seconds() const
+{
+    return _assignmentTimeout;
+}
+
+bool Options::guided_neighbors() const
+{
+    return _guidedNeighbors;
+}
+
 void Options::set_verbosity(int verbosity)
 {
     _verbosity = verbosity;
@@ -244,3 +306,33 @@ void Options::set_max_neighbors(int maxNeighbors)
 {
     _maxNeighbors = maxNeighbors;
 }
+
+void Options::set_cache_size(int cacheSize)
+{
+    _cacheSize = cacheSize;
+}
+
+void Options::set_assignment_backend(AssignmentBackend assignmentBackend)
+{
+    _assignmentBackend = assignmentBackend;
+}
+
+void Options::set_compare_backends(bool compareBackends)
+{
+    _compareBackends = compareBackends;
+}
+
+void Options::set_lexicographic(bool lexicographic)
+{
+    _lexicographic = lexicographic;
+}
+
+void Options::set_assignment_timeout_seconds(int assignmentTimeoutSeconds)
+{
+    _assignmentTimeout = assignmentTimeoutSeconds;
+}
+
+void Options::set_guided_neighbors(bool guidedNeighbors)
+{
+    _guidedNeighbors = guidedNeighbors;
+}
@@ -27,6 +27,18 @@ enum OptionsParseStatus
     ERROR
 };
 
+/**
+ * The backends that can be used to solve the assignment flow instances.
+ */
+enum AssignmentBackend
+{
+    AutoBackend,
+    NativeBackend,
+    CbcBackend,
+    CpSatBackend,
+    GlopBackend
+};
+
 /**
  * Contains and parses the command line options given to wassign.
  */
@@ -44,6 +56,12 @@ private:
     int _threadCount = (int)std::thread::hardware_concurrency();
     int _maxNeighbors = 16;
     bool _greedy = false;
+    int _cacheSize = 256;
+    AssignmentBackend _assignmentBackend = AutoBackend;
+    bool _compareBackends = false;
+    bool _lexicographic = false;
+    int _assignmentTimeout = 0;
+    bool _guidedNeighbors = false;
 
     OptionsParseStatus parse_base(int argc, char** argv, bool newOpt, string const& header);
 
@@ -55,8 +73,18 @@ private:
             {'w', 60 * 60 * 24 * 7},
     };
 
+    inline static const vector<pair<string, AssignmentBackend>> _backendNames = {
+            {"auto", AutoBackend},
+            {"native", NativeBackend},
+            {"cbc", CbcBackend},
+            {"cp-sat", CpSatBackend},
+            {"glop", GlopBackend},
+    };
+
     static int parse_time(string value);
 
+    static AssignmentBackend parse_assignment_backend(string const& value);
+
 public:
     Options() = default;
 
@@ -66,6 +94,8 @@ public:
 
     static shared_ptr<Options> default_options();
 
+    static string assignment_backend_name(AssignmentBackend backend);
+
     [[nodiscard]] int verbosity() const;
 
     [[nodiscard]] vector<string> input_files() const;
@@ -88,6 +118,18 @@ public:
 
     [[nodiscard]] bool greedy() const;
 
+    [[nodiscard]] int cache_size() const;
+
+    [[nodiscard]] AssignmentBackend assignment_backend() const;
+
+    [[nodiscard]] bool compare_backends() const;
+
+    [[nodiscard]] bool lexicographic() const;
+
+    [[nodiscard]] int assignment_timeout_seconds() const;
+
+    [[nodiscard]] bool guided_neighbors() const;
+
     void set_verbosity(int verbosity);
 
     void set_input_files(vector<string> inputFiles);
@@ -109,6 +151,18 @@ public:
     void set_max_neighbors(int maxNeighbors);
 
     void set_greedy(bool greedy);
+
+    void set_cache_size(int cacheSize);
+
+    void set_assignment_backend(AssignmentBackend assignmentBackend);
+
+    void set_compare_backends(bool compareBackends);
+
+    void set_lexicographic(bool lexicographic);
+
+    void set_assignment_timeout_seconds(int assignmentTimeoutSeconds);
+
+    void set_guided_neighbors(bool guidedNeighbors);
 };
 
 
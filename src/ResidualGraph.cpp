@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ResidualGraph.h"
+
+#include <queue>
+
+ResidualGraph::ResidualGraph(int nodeCount)
+        : _adjacent(nodeCount)
+{
+}
+
+int ResidualGraph::add_edge(int fromNode, int toNode, int capacity, long cost)
+{
+    _adjacent[fromNode].push_back(_arcs.size());
+    _arcs.push_back({toNode, capacity, cost});
+
+    _adjacent[toNode].push_back(_arcs.size());
+    _arcs.push_back({fromNode, 0, -cost});
+
+    return _arcs.size() / 2 - 1;
+}
+
+void ResidualGraph::resize(int nodeCount, int arcCount)
+{
+    _arcs.resize(arcCount);
+    _adjacent.resize(nodeCount);
+
+    for(vector<int>& adjacent : _adjacent)
+    {
+        while(!adjacent.empty() && adjacent.back() >= arcCount)
+        {
+            adjacent.pop_back();
+        }
+    }
+}
+
+bool ResidualGraph::calculate_levels(int source, int sink, vector<long> const& potential)
+{
+    std::fill(_level.begin(), _level.end(), -1);
+    std::queue<int> queue;
+
+    _level[source] = 0;
+    queue.push(source);
+
+    while(!queue.empty())
+    {
+        int node = queue.front();
+        queue.pop();
+
+        for(int arcIdx : _adjacent[node])
+        {
+            Arc const& arc = _arcs[arcIdx];
+            if(arc.capacity <= 0 || _level[arc.to] >= 0) continue;
+            if(arc.cost + potential[node] - potential[arc.to] != 0) continue;
+
+            _level[arc.to] = _level[node] + 1;
+            queue.push(arc.to);
+        }
+    }
+
+    return _level[sink] >= 0;
+}
+
+int ResidualGraph::push(int node, int sink, int amount, vector<long> const& potential)
+{
+    if(node == sink)
+    {
+        return amount;
+    }
+
+    for(int& i = _currentArc[node]; i < _adjacent[node].size(); i++)
+    {
+        int arcIdx = _adjacent[node][i];
+        Arc& arc = _arcs[arcIdx];
+
+        if(arc.capacity <= 0 || _level[arc.to] != _level[node] + 1) continue;
+        if(arc.cost + potential[node] - potential[arc.to] != 0) continue;
+
+        int pushed = push(arc.to, sink, std::min(amount, arc.capacity), potential);
+        if(pushed > 0)
+        {
+            arc.capacity -= pushed;
+            _arcs[arcIdx ^ 1].capacity += pushed;
+            return pushed;
+        }
+    }
+
+    return 0;
+}
+
+int ResidualGraph::augment(int source, int sink, int amount, vector<long> const& potential)
+{
+    _level.resize(_adjacent.size());
+    _currentArc.resize(_adjacent.size());
+
+    int total = 0;
+    while(total < amount && calculate_levels(source, sink, potential))
+    {
+        std::fill(_currentArc.begin(), _currentArc.end(), 0);
+
+        int pushed;
+        while(total < amount && (pushed = push(source, sink, amount - total, potential)) > 0)
+        {
+            total += pushed;
+        }
+    }
+
+    return total;
+}
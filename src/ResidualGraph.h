@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Types.h"
+
+/**
+ * A residual graph for integral flow algorithms. Arcs are always added in pairs: arc 2i is the forward arc of edge i
+ * and arc 2i+1 is the corresponding backward arc, so the flow of edge i is always the residual capacity of arc 2i+1.
+ *
+ * Blocking flows are computed with Dinic's algorithm on the admissible arcs, which are all arcs with residual capacity
+ * and zero reduced cost with respect to the given node potentials. With zero costs (or zero potentials and zero costs),
+ * all arcs with residual capacity are admissible. This is shared by MaxFlow and MinCostFlow.
+ */
+class ResidualGraph
+{
+public:
+    struct Arc
+    {
+        int to;
+        int capacity;
+        long cost;
+    };
+
+private:
+    vector<Arc> _arcs;
+    vector<vector<int>> _adjacent;
+    vector<int> _level;
+    vector<int> _currentArc;
+
+    /**
+     * Calculates the BFS levels of the admissible arcs. Returns false if the sink is not reachable.
+     */
+    bool calculate_levels(int source, int sink, vector<long> const& potential);
+
+    /**
+     * Pushes up to the given amount of flow from the given node to the sink along the admissible level graph.
+     */
+    int push(int node, int sink, int amount, vector<long> const& potential);
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param nodeCount The initial number of nodes.
+     */
+    explicit ResidualGraph(int nodeCount);
+
+    /**
+     * Adds a forward and a backward arc for an edge and returns the index of the edge.
+     */
+    int add_edge(int fromNode, int toNode, int capacity, long cost = 0);
+
+    /**
+     * Changes the number of nodes. When nodes are removed, all arcs from index arcCount on have to be removed as well.
+     */
+    void resize(int nodeCount, int arcCount);
+
+    /**
+     * Augments a blocking flow of at most the given amount from the source to the sink, repeatedly until the sink is
+     * not reachable over admissible arcs anymore. Returns the total amount of flow pushed. The potentials have to
+     * contain one entry for each node.
+     */
+    int augment(int source, int sink, int amount, vector<long> const& potential);
+
+    /**
+     * Returns the arc with the given index.
+     */
+    [[nodiscard]] Arc& arc(int arcIdx)
+    {
+        return _arcs[arcIdx];
+    }
+
+    [[nodiscard]] Arc const& arc(int arcIdx) const
+    {
+        return _arcs[arcIdx];
+    }
+
+    /**
+     * Returns the indices of the arcs leaving the given node.
+     */
+    [[nodiscard]] vector<int> const& adjacent(int node) const
+    {
+        return _adjacent[node];
+    }
+
+    /**
+     * Returns the flow of the given edge.
+     */
+    [[nodiscard]] int flow(int edge) const
+    {
+        return _arcs[2 * edge + 1].capacity;
+    }
+
+    /**
+     * Returns the number of nodes.
+     */
+    [[nodiscard]] int node_count() const
+    {
+        return _adjacent.size();
+    }
+
+    /**
+     * Returns the number of arcs.
+     */
+    [[nodiscard]] int arc_count() const
+    {
+        return _arcs.size();
+    }
+};
@@ -23,95 +23,345 @@
 #include "Util.h"
 #include "Options.h"
 
-int SchedulingSolver::calculate_available_max_push(vector<int> const& choiceScramble, int depth)
+SchedulingSolver::SearchState::SearchState(InputData const& inputData,
+                                           vector<CriticalSet> const& criticalSets,
+                                           vector<vector<int>> const& setsOfChoice)
+    : slotOf(inputData.choice_count(), -1),
+      slotMinSum(inputData.slot_count(), 0),
+      slotMaxSum(inputData.slot_count(), 0),
+      slotSize(inputData.slot_count(), 0),
+      domains(inputData.choice_count() * inputData.slot_count(), true),
+      domainSize(inputData.choice_count(), inputData.slot_count()),
+      depthOf(inputData.choice_count(), -1),
+      removedBy(inputData.choice_count() * inputData.slot_count(), -1),
+      setsOfChoice(setsOfChoice),
+      setMissing(criticalSets.size()),
+      setSlotHits(criticalSets.size() * inputData.slot_count(), 0),
+      setCoveredSlots(criticalSets.size(), 0)
 {
-    int push = 0;
-    for(; depth < choiceScramble.size(); depth++)
+    for(int w = 0; w < inputData.choice_count(); w++)
     {
-        push += _inputData->choice(choiceScramble[depth]).max;
+        availableMaxPush += inputData.choice(w).max;
     }
 
-    return push;
+    for(int k = 0; k < criticalSets.size(); k++)
+    {
+        setMissing[k] = criticalSets[k].size();
+        if(setMissing[k] < inputData.slot_count())
+        {
+            violatedSetCount++;
+        }
+    }
 }
 
-bool SchedulingSolver::satisfies_critical_sets(map<int, int> const& decisions, vector<CriticalSet> const& criticalSets)
+void SchedulingSolver::remove_from_domain(SearchState& state, int choice, int slot)
 {
-    set<int> coveredSlots;
-    for(CriticalSet const& set : criticalSets)
+    auto bit = state.domains[choice * _inputData->slot_count() + slot];
+    if(!bit) return;
+
+    bit = false;
+    state.trail.emplace_back(choice, slot);
+    state.removedBy[choice * _inputData->slot_count() + slot] = state.decisionCount - 1;
+
+    if(--state.domainSize[choice] == 0)
     {
-        coveredSlots.clear();
-        int missing = 0;
+        state.emptyDomainCount++;
+    }
+}
 
-        for(int element : set.elements())
+void SchedulingSolver::restrict_root_domains(SearchState& state)
+{
+    for(Constraint constraint : _inputData->scheduling_constraints())
+    {
+        switch(constraint.type())
         {
-            auto slotIt = decisions.find(element);
-
-            if(slotIt == decisions.end())
+            case ChoiceIsInSlot:
             {
-                missing++;
+                for(int s = 0; s < _inputData->slot_count(); s++)
+                {
+                    if(s != constraint.right()) remove_from_domain(state, constraint.left(), s);
+                }
+                break;
             }
-            else
+
+            case ChoiceIsNotInSlot: remove_from_domain(state, constraint.left(), constraint.right()); break;
+
+            case ChoicesHaveOffset:
             {
-                coveredSlots.insert(slotIt->second);
+                // slot(right) = slot(left) + offset has to be a valid slot for both choices.
+                //
+                for(int s = 0; s < _inputData->slot_count(); s++)
+                {
+                    if(s + constraint.extra() < 0 || s + constraint.extra() >= _inputData->slot_count())
+                    {
+                        remove_from_domain(state, constraint.left(), s);
+                    }
+
+                    if(s - constraint.extra() < 0 || s - constraint.extra() >= _inputData->slot_count())
+                    {
+                        remove_from_domain(state, constraint.right(), s);
+                    }
+                }
+                break;
             }
-        }
 
-        if(coveredSlots.size() + missing < _inputData->slot_count())
-        {
-            return false;
+            default: break;
         }
     }
 
-    return true;
+    // Root removals are never reverted.
+    //
+    state.trail.clear();
 }
 
-bool SchedulingSolver::satisfies_scheduling_constraints(int choice, int slot, map<int, int> const& decisions)
+void SchedulingSolver::assign(SearchState& state, int choice, int slot)
 {
+    state.slotOf[choice] = slot;
+    state.depthOf[choice] = state.decisionCount;
+    update_critical_sets(state, choice, slot, 1);
+    state.slotMinSum[slot] += _inputData->choice(choice).min;
+    state.slotMaxSum[slot] += _inputData->choice(choice).max;
+    state.slotSize[slot]++;
+    state.availableMaxPush -= _inputData->choice(choice).max;
+    state.decisionCount++;
+
+    state.trailMarks.push_back(state.trail.size());
+
     for(Constraint constraint : _inputData->scheduling_constraints(choice))
     {
-        switch(constraint.type())
+        if(constraint.type() != ChoicesAreInSameSlot
+           && constraint.type() != ChoicesAreNotInSameSlot
+           && constraint.type() != ChoicesHaveOffset)
         {
-            case ChoiceIsInSlot: if(slot != constraint.right()) return false; break;
-            case ChoiceIsNotInSlot: if(slot == constraint.right()) return false; break;
+            continue;
+        }
+
+        int other = constraint.left() == choice ? constraint.right() : constraint.left();
+        if(state.slotOf[other] >= 0) continue;
 
+        switch(constraint.type())
+        {
             case ChoicesAreInSameSlot:
             {
-                int other = constraint.left() == choice ? constraint.right() : constraint.left();
-                auto otherSlotIt = decisions.find(other);
-                if(otherSlotIt != decisions.end() && otherSlotIt->second != slot)
+                for(int s = 0; s < _inputData->slot_count(); s++)
                 {
-                    return false;
+                    if(s != slot) remove_from_domain(state, other, s);
                 }
                 break;
             }
 
-            case ChoicesAreNotInSameSlot:
-            {
-                int other = constraint.left() == choice ? constraint.right() : constraint.left();
-                auto otherSlotIt = decisions.find(other);
-                if(otherSlotIt != decisions.end() && otherSlotIt->second == slot)
-                {
-                    return false;
-                }
-                break;
-            }
+            case ChoicesAreNotInSameSlot: remove_from_domain(state, other, slot); break;
 
             case ChoicesHaveOffset:
             {
-                int other = constraint.left() == choice ? constraint.right() : constraint.left();
                 int offset = other == constraint.left() ? -constraint.extra() : constraint.extra();
-                auto otherSlotIt = decisions.find(other);
-                if(otherSlotIt != decisions.end() && otherSlotIt->second - slot != offset)
+                for(int s = 0; s < _inputData->slot_count(); s++)
                 {
-                    return false;
+                    if(s != slot + offset) remove_from_domain(state, other, s);
                 }
+                break;
+            }
+
+            default: break;
+        }
+    }
+}
+
+void SchedulingSolver::unassign(SearchState& state, int choice)
+{
+    for(size_t mark = state.trailMarks.back(); state.trail.size() > mark; state.trail.pop_back())
+    {
+        auto [w, s] = state.trail.back();
+        state.domains[w * _inputData->slot_count() + s] = true;
+
+        if(state.domainSize[w]++ == 0)
+        {
+            state.emptyDomainCount--;
+        }
+    }
+
+    state.trailMarks.pop_back();
+
+    int slot = state.slotOf[choice];
+
+    state.slotOf[choice] = -1;
+    state.depthOf[choice] = -1;
+    update_critical_sets(state, choice, slot, -1);
+    state.slotMinSum[slot] -= _inputData->choice(choice).min;
+    state.slotMaxSum[slot] -= _inputData->choice(choice).max;
+    state.slotSize[slot]--;
+    state.availableMaxPush += _inputData->choice(choice).max;
+    state.decisionCount--;
+}
+
+void SchedulingSolver::add_global_conflict(SearchState const& state, ordered_set<int>& conflict)
+{
+    for(int depth = 0; depth < state.decisionCount; depth++)
+    {
+        conflict.insert(depth);
+    }
+}
+
+void SchedulingSolver::add_domain_conflict(SearchState const& state, int choice, ordered_set<int>& conflict)
+{
+    for(int s = 0; s < _inputData->slot_count(); s++)
+    {
+        int idx = choice * _inputData->slot_count() + s;
+        if(!state.domains[idx] && state.removedBy[idx] >= 0)
+        {
+            conflict.insert(state.removedBy[idx]);
+        }
+    }
+}
+
+void SchedulingSolver::add_slot_conflict(SearchState const& state, int choice, int slot, ordered_set<int>& conflict)
+{
+    int idx = choice * _inputData->slot_count() + slot;
+    if(!state.domains[idx])
+    {
+        if(state.removedBy[idx] >= 0) conflict.insert(state.removedBy[idx]);
+    }
+    else if(state.decisionCount + 1 == _inputData->choice_count())
+    {
+        // The final slot size check involves all slots.
+        //
+        add_global_conflict(state, conflict);
+    }
+    else
+    {
+        // Otherwise, the slot is excluded by its minimum chooser count or its size limit, which only depend on the
+        // choices already in the slot.
+        //
+        for(int w = 0; w < _inputData->choice_count(); w++)
+        {
+            if(state.slotOf[w] == slot) conflict.insert(state.depthOf[w]);
+        }
+    }
+}
+
+bool SchedulingSolver::violates_nogood(SearchState const& state,
+                                       NogoodStore const& nogoods,
+                                       int choice,
+                                       int slot,
+                                       ordered_set<int>& conflict)
+{
+    auto it = nogoods.byDecision.find(choice * _inputData->slot_count() + slot);
+    if(it == nogoods.byDecision.end()) return false;
+
+    for(int nogoodIdx : it->second)
+    {
+        auto const& nogood = nogoods.nogoods[nogoodIdx];
+
+        bool violated = std::all_of(nogood.begin(), nogood.end(), [&](pair<int, int> const& decision)
+        {
+            return decision.first == choice || state.slotOf[decision.first] == decision.second;
+        });
+
+        if(!violated) continue;
+
+        for(auto const& [w, s] : nogood)
+        {
+            if(w != choice) conflict.insert(state.depthOf[w]);
+        }
+
+        _nogoodPruneCount++;
+        return true;
+    }
+
+    return false;
+}
+
+void SchedulingSolver::learn_nogood(SearchState const& state,
+                                    NogoodStore& nogoods,
+                                    vector<int> const& choiceOrder,
+                                    ordered_set<int> const& conflict)
+{
+    if(conflict.empty())
+    {
+        nogoods.infeasible = true;
+        return;
+    }
 
-                int minSlot = std::max(0, 0 - offset);
-                int maxSlot = std::min(_inputData->slot_count(), _inputData->slot_count() - offset);
+    if(conflict.size() > MAX_NOGOOD_SIZE || nogoods.nogoods.size() >= MAX_NOGOODS)
+    {
+        return;
+    }
+
+    vector<pair<int, int>> nogood;
+    for(int depth : conflict)
+    {
+        int w = choiceOrder[depth];
+        nogood.emplace_back(w, state.slotOf[w]);
+        nogoods.byDecision[w * _inputData->slot_count() + state.slotOf[w]].push_back(nogoods.nogoods.size());
+    }
+
+    nogoods.nogoods.push_back(std::move(nogood));
+}
+
+void SchedulingSolver::update_critical_sets(SearchState& state, int choice, int slot, int delta)
+{
+    int slotCount = _inputData->slot_count();
+
+    for(int k : state.setsOfChoice[choice])
+    {
+        bool wasViolated = state.setCoveredSlots[k] + state.setMissing[k] < slotCount;
+
+        int& hits = state.setSlotHits[k * slotCount + slot];
+        if(delta > 0 ? hits++ == 0 : --hits == 0)
+        {
+            state.setCoveredSlots[k] += delta;
+        }
+
+        state.setMissing[k] -= delta;
+
+        bool isViolated = state.setCoveredSlots[k] + state.setMissing[k] < slotCount;
+        state.violatedSetCount += (int)isViolated - (int)wasViolated;
+    }
+}
+
+bool SchedulingSolver::satisfies_critical_sets(SearchState const& state,
+                                               vector<CriticalSet> const& criticalSets,
+                                               ordered_set<int>& conflict)
+{
+    if(state.violatedSetCount == 0)
+    {
+        return true;
+    }
+
+    for(int k = 0; k < criticalSets.size(); k++)
+    {
+        if(state.setCoveredSlots[k] + state.setMissing[k] >= _inputData->slot_count()) continue;
+
+        for(int element : criticalSets[k].elements())
+        {
+            if(state.slotOf[element] >= 0) conflict.insert(state.depthOf[element]);
+        }
 
-                if(slot < minSlot || slot >= maxSlot) return false;
+        break;
+    }
+
+    return false;
+}
+
+bool SchedulingSolver::satisfies_scheduling_constraints(int choice, int slot, SearchState const& state)
+{
+    if(!state.domains[choice * _inputData->slot_count() + slot])
+    {
+        return false;
+    }
+
+    for(Constraint constraint : _inputData->scheduling_constraints(choice))
+    {
+        switch(constraint.type())
+        {
+            // These are enforced by the slot domains.
+            //
+            case ChoiceIsInSlot:
+            case ChoiceIsNotInSlot:
+            case ChoicesAreInSameSlot:
+            case ChoicesAreNotInSameSlot:
+            case ChoicesHaveOffset:
                 break;
-            }
 
             case SlotHasLimitedSize:
             {
@@ -123,13 +373,7 @@ bool SchedulingSolver::satisfies_scheduling_constraints(int choice, int slot, ma
                 if(constraint.extra() == Neq || constraint.extra() == Gt || constraint.extra() == Geq) break;
 
                 int limit = constraint.right() - (constraint.extra() == Lt ? 1 : 0);
-
-                for(auto const& decision : decisions)
-                {
-                    if(decision.second == slot) limit--;
-                }
-
-                if(limit < 0) return false;
+                if(state.slotSize[slot] > limit) return false;
 
                 break;
             }
@@ -138,11 +382,11 @@ bool SchedulingSolver::satisfies_scheduling_constraints(int choice, int slot, ma
         }
     }
 
-    if(decisions.size() + 1 == _inputData->choice_count())
+    if(state.decisionCount + 1 == _inputData->choice_count())
     {
         // This is the last decision to be made, time to check slot size constraints.
         //
-        return check_slot_size_constraints(choice, slot, decisions);
+        return check_slot_size_constraints(choice, slot, state);
     }
     else
     {
@@ -150,36 +394,23 @@ bool SchedulingSolver::satisfies_scheduling_constraints(int choice, int slot, ma
     }
 }
 
-bool SchedulingSolver::check_slot_size_constraints([[maybe_unused]] int choice, int slot, map<int, int> const& decisions)
+bool SchedulingSolver::check_slot_size_constraints([[maybe_unused]] int choice, int slot, SearchState const& state)
 {
-    // these will be counted lazily so we don't have to compute slot sizes if there are no slot size constraints.
-    //
-    vector<int> slotSizes;
-
     for(Constraint constraint : _inputData->scheduling_constraints())
     {
         if(constraint.type() != SlotHasLimitedSize) continue;
 
-        if(slotSizes.empty())
-        {
-            slotSizes.resize(_inputData->slot_count());
-            slotSizes[slot]++;
-            for(int w = 0; w < _inputData->choice_count(); w++)
-            {
-                if(choice == w) continue;
-                slotSizes[decisions.at(w)]++;
-            }
-        }
+        int slotSize = state.slotSize[constraint.left()] + (constraint.left() == slot ? 1 : 0);
 
         bool valid = false;
         switch(constraint.extra())
         {
-            case Eq: valid = slotSizes[constraint.left()] == constraint.right(); break;
-            case Neq: valid = slotSizes[constraint.left()] != constraint.right(); break;
-            case Lt: valid = slotSizes[constraint.left()] < constraint.right(); break;
-            case Leq: valid = slotSizes[constraint.left()] <= constraint.right(); break;
-            case Gt: valid = slotSizes[constraint.left()] > constraint.right(); break;
-            case Geq: valid = slotSizes[constraint.left()] >= constraint.right(); break;
+            case Eq: valid = slotSize == constraint.right(); break;
+            case Neq: valid = slotSize != constraint.right(); break;
+            case Lt: valid = slotSize < constraint.right(); break;
+            case Leq: valid = slotSize <= constraint.right(); break;
+            case Gt: valid = slotSize > constraint.right(); break;
+            case Geq: valid = slotSize >= constraint.right(); break;
         }
 
         if(!valid) return false;
@@ -188,18 +419,11 @@ bool SchedulingSolver::check_slot_size_constraints([[maybe_unused]] int choice,
     return true;
 }
 
-bool SchedulingSolver::has_impossibilities(map<int, int> const& decisions, int availableMaxPush)
+bool SchedulingSolver::has_impossibilities(SearchState const& state)
 {
     for(int s = 0; s < _inputData->slot_count(); s++)
     {
-        int sum = availableMaxPush;
-        for(auto const& decision : decisions)
-        {
-            if(decision.second != s) continue;
-            sum += _inputData->choice(decision.first).max;
-        }
-
-        if(sum < _inputData->chooser_count())
+        if(state.availableMaxPush + state.slotMaxSum[s] < _inputData->chooser_count())
         {
             return true;
         }
@@ -208,21 +432,15 @@ bool SchedulingSolver::has_impossibilities(map<int, int> const& decisions, int a
     return false;
 }
 
-vector<int>
-SchedulingSolver::calculate_critical_sets(map<int, int> const& decisions, int availableMaxPush, int choice)
+vector<int> SchedulingSolver::calculate_critical_sets(SearchState const& state, int choice)
 {
     vector<int> criticalSets;
 
     for(int s = 0; s < _inputData->slot_count(); s++)
     {
-        int sum = availableMaxPush - _inputData->choice(choice).max;
-        for(auto const& decision : decisions)
-        {
-            if(decision.second != s) continue;
-            sum += _inputData->choice(decision.first).max;
-        }
+        int sum = state.availableMaxPush - _inputData->choice(choice).max + state.slotMaxSum[s];
 
-        if(sum >= _inputData->chooser_count() || !satisfies_scheduling_constraints(choice, s, decisions))
+        if(sum >= _inputData->chooser_count() || !satisfies_scheduling_constraints(choice, s, state))
         {
             continue;
         }
@@ -233,20 +451,15 @@ SchedulingSolver::calculate_critical_sets(map<int, int> const& decisions, int av
     return criticalSets;
 }
 
-int SchedulingSolver::slot_order_heuristic_score(map<int, int> const& decisions, int set)
+int SchedulingSolver::slot_order_heuristic_score(SearchState const& state, int set)
 {
-    int score = 0;
-    for(auto const& decision : decisions)
-    {
-        if(decision.second != set) continue;
-        score += _inputData->choice(decision.first).max;
-    }
-
-    return score;
+    return state.slotMaxSum[set];
 }
 
-vector<int>
-SchedulingSolver::calculate_feasible_slots(map<int, int> const& decisions, vector<bool> const& lowPrioritySlot, int choice)
+vector<int> SchedulingSolver::calculate_feasible_slots(SearchState const& state,
+                                                       vector<bool> const& lowPrioritySlot,
+                                                       int choice,
+                                                       ordered_set<int>& conflict)
 {
     // Feasible slots are all slots for which adding the current choice would not cause the
     // minimal chooser number of this slot to exceed the total chooser count.
@@ -261,15 +474,11 @@ SchedulingSolver::calculate_feasible_slots(map<int, int> const& decisions, vecto
 
     for(int s = 0; s < _inputData->slot_count(); s++)
     {
-        int sum = _inputData->choice(choice).min;
-        for(auto const& decision : decisions)
-        {
-            if(decision.second != s) continue;
-            sum += _inputData->choice(decision.first).min;
-        }
+        int sum = _inputData->choice(choice).min + state.slotMinSum[s];
 
-        if(sum > _inputData->chooser_count() || !satisfies_scheduling_constraints(choice, s, decisions))
+        if(sum > _inputData->chooser_count() || !satisfies_scheduling_constraints(choice, s, state))
         {
+            add_slot_conflict(state, choice, s, conflict);
             continue;
         }
 
@@ -280,7 +489,7 @@ SchedulingSolver::calculate_feasible_slots(map<int, int> const& decisions, vecto
         else
         {
             normalSlots.push_back(s);
-            slotScore[s] = slot_order_heuristic_score(decisions, s);
+            slotScore[s] = slot_order_heuristic_score(state, s);
         }
     }
 
@@ -303,6 +512,22 @@ vector<int> SchedulingSolver::get_choice_scramble()
     return choiceScramble;
 }
 
+int SchedulingSolver::next_choice(SearchState const& state, vector<int> const& choiceScramble)
+{
+    int best = -1;
+    for(int w : choiceScramble)
+    {
+        if(state.slotOf[w] >= 0) continue;
+
+        if(best < 0 || state.domainSize[w] < state.domainSize[best])
+        {
+            best = w;
+        }
+    }
+
+    return best;
+}
+
 vector<bool> SchedulingSolver::get_low_priority_slots()
 {
     vector<bool> lowPrioritySet(_inputData->slot_count());
@@ -314,24 +539,47 @@ vector<bool> SchedulingSolver::get_low_priority_slots()
     return lowPrioritySet;
 }
 
-vector<vector<int>> SchedulingSolver::convert_decisions(map<int, int> const& decisions)
+vector<vector<int>> SchedulingSolver::convert_decisions(SearchState const& state)
 {
     vector<vector<int>> res(_inputData->slot_count());
-    for(auto const& decision : decisions)
+    for(int w = 0; w < _inputData->choice_count(); w++)
     {
-        res[decision.second].push_back(decision.first);
+        res[state.slotOf[w]].push_back(w);
     }
 
     return res;
 }
 
-vector<vector<int>> SchedulingSolver::solve_scheduling(vector<CriticalSet> const& criticalSets, datetime timeLimit)
+vector<vector<int>> SchedulingSolver::solve_scheduling(vector<CriticalSet> const& criticalSets,
+                                                       vector<vector<int>> const& setsOfChoice,
+                                                       NogoodStore& nogoods,
+                                                       datetime timeLimit)
 {
+    if(nogoods.infeasible)
+    {
+        return {};
+    }
+
+    _searchCount++;
+
     vector<int> choiceScramble = get_choice_scramble();
     vector<bool> lowPrioritySet = get_low_priority_slots();
 
-    map<int, int> decisions;
+    SearchState state(*_inputData, criticalSets, setsOfChoice);
+    restrict_root_domains(state);
+
+    if(state.emptyDomainCount > 0)
+    {
+        nogoods.infeasible = true;
+        return {};
+    }
+
+    // For each depth, the choice decided at this depth and the depths of the earlier decisions responsible for
+    // excluding its options (its conflict set).
+    //
     stack<vector<int>> backtracking;
+    vector<int> choiceOrder;
+    vector<ordered_set<int>> conflicts;
 
     for(int depth = 0; depth < choiceScramble.size();)
     {
@@ -340,16 +588,31 @@ vector<vector<int>> SchedulingSolver::solve_scheduling(vector<CriticalSet> const
             return {};
         }
 
-        int choice = choiceScramble[depth];
+        if(backtracking.size() <= depth)
+        {
+            choiceOrder.push_back(next_choice(state, choiceScramble));
+            conflicts.emplace_back();
+        }
+
+        int choice = choiceOrder[depth];
 
         if(backtracking.size() <= depth)
         {
-            int availableMaxPush = calculate_available_max_push(choiceScramble, depth);
+            auto& conflict = conflicts[depth];
 
+            // If any domain was wiped out by the last decision, the current partial solution is infeasible. Since
+            // choices with the smallest domain are decided first, this is the domain of the current choice.
+            //
+            if(state.emptyDomainCount > 0)
+            {
+                add_domain_conflict(state, choice, conflict);
+                backtracking.push({});
+            }
             // If there are any impossibilities, the current partial solution is infeasible.
             //
-            if(has_impossibilities(decisions, availableMaxPush))
+            else if(has_impossibilities(state))
             {
+                add_global_conflict(state, conflict);
                 backtracking.push({});
             }
             else
@@ -368,25 +631,37 @@ vector<vector<int>> SchedulingSolver::solve_scheduling(vector<CriticalSet> const
                 // Would not be feasible, because the critical set can not be covered anymore (we would need at
                 // least 2 open choices in the critical set to cover Set 3 and 4).
                 //
-                if(!satisfies_critical_sets(decisions, criticalSets))
+                if(!satisfies_critical_sets(state, criticalSets, conflict))
                 {
                     backtracking.push({});
                 }
                 else
                 {
-                    vector<int> criticalSets = calculate_critical_sets(decisions, availableMaxPush, choice);
+                    vector<int> criticalSets = calculate_critical_sets(state, choice);
 
                     if(criticalSets.size() == 1)
                     {
+                        add_global_conflict(state, conflict);
+                        if(violates_nogood(state, nogoods, choice, criticalSets.front(), conflict))
+                        {
+                            criticalSets.clear();
+                        }
+
                         backtracking.push(criticalSets);
                     }
                     else if(criticalSets.size() > 1)
                     {
+                        add_global_conflict(state, conflict);
                         backtracking.push({});
                     }
                     else
                     {
-                        vector<int> feasibleSets = calculate_feasible_slots(decisions, lowPrioritySet, choice);
+                        vector<int> feasibleSets = calculate_feasible_slots(state, lowPrioritySet, choice, conflict);
+                        feasibleSets.erase(std::remove_if(feasibleSets.begin(), feasibleSets.end(), [&](int s)
+                        {
+                            return violates_nogood(state, nogoods, choice, s, conflict);
+                        }), feasibleSets.end());
+
                         backtracking.push(feasibleSets);
                     }
                 }
@@ -395,29 +670,43 @@ vector<vector<int>> SchedulingSolver::solve_scheduling(vector<CriticalSet> const
 
         if(backtracking.top().empty())
         {
-            if(depth == 0)
+            // All options of this choice failed because of the decisions in its conflict set. These can not all be
+            // part of a solution, and the search jumps back to the deepest one of them. If the conflict set is empty,
+            // there is no solution.
+            //
+            ordered_set<int> reasons = std::move(conflicts[depth]);
+            learn_nogood(state, nogoods, choiceOrder, reasons);
+
+            if(reasons.empty())
             {
-                // no solution
-                //
                 return {};
             }
 
-            // backtrack
-            //
-            backtracking.pop();
-            decisions.erase(choiceScramble[depth - 1]);
-            depth--;
+            int target = *reasons.rbegin();
+            reasons.erase(target);
+            _skippedLevelCount += depth - target - 1;
+
+            while(depth > target)
+            {
+                backtracking.pop();
+                choiceOrder.pop_back();
+                conflicts.pop_back();
+                depth--;
+                unassign(state, choiceOrder[depth]);
+            }
+
+            conflicts[target].insert(reasons.begin(), reasons.end());
             continue;
         }
 
         int nextSet = backtracking.top().front();
         auto& top = backtracking.top();
         top.erase(std::remove(top.begin(), top.end(), nextSet), top.end());
-        decisions[choice] = nextSet;
+        assign(state, choice, nextSet);
         depth++;
     }
 
-    return convert_decisions(decisions);
+    return convert_decisions(state);
 }
 
 SchedulingSolver::SchedulingSolver(const_ptr<InputData> inputData,
@@ -443,13 +732,14 @@ bool SchedulingSolver::next_scheduling()
 
     while(sets.empty())
     {
-        vector<CriticalSet> csSets = _csAnalysis->for_preference(preferenceLimit);
+        vector<CriticalSet> const& csSets = _csAnalysis->for_preference(preferenceLimit);
+        vector<vector<int>> const& setsOfChoice = _csAnalysis->sets_of_choice(preferenceLimit);
 
         datetime timeLimit =  preferenceLimit == _inputData->max_preference()
                               ? time_never()
                               : time_now() + seconds(_options->critical_set_timeout_seconds());
 
-        sets = solve_scheduling(csSets, timeLimit);
+        sets = solve_scheduling(csSets, setsOfChoice, _nogoods[preferenceLimit], timeLimit);
 
         if(sets.empty())
         {
@@ -478,3 +768,18 @@ bool SchedulingSolver::next_scheduling()
 
     return true;
 }
+
+int SchedulingSolver::search_count() const
+{
+    return _searchCount;
+}
+
+int SchedulingSolver::skipped_level_count() const
+{
+    return _skippedLevelCount;
+}
+
+int SchedulingSolver::nogood_prune_count() const
+{
+    return _nogoodPruneCount;
+}
@@ -37,80 +37,274 @@ private:
     const_ptr<Options> _options;
     cancel_token _cancellation;
 
+    int _searchCount = 0;
+    int _skippedLevelCount = 0;
+    int _nogoodPruneCount = 0;
+
+    /**
+     * Dense state of the partial scheduling during the backtracking search. The running sums per slot are updated with
+     * every decision, so that no search step has to scan all previous decisions.
+     */
+    struct SearchState
+    {
+        /**
+         * The slot of each choice, or -1 if the choice is not assigned yet.
+         */
+        vector<int> slotOf;
+
+        /**
+         * The sums of the minimum and maximum chooser counts of the choices assigned to each slot.
+         */
+        vector<int> slotMinSum;
+        vector<int> slotMaxSum;
+
+        /**
+         * The number of choices assigned to each slot.
+         */
+        vector<int> slotSize;
+
+        /**
+         * The available max push is the sum of the maximum chooser counts of all choices that are not yet assigned
+         * to a set (the maximum number of choosers that can be covered with all choices that are not
+         * yet assigned to a set).
+         */
+        int availableMaxPush = 0;
+
+        /**
+         * The number of choices assigned so far.
+         */
+        int decisionCount = 0;
+
+        /**
+         * The slot domain of each choice: domains[choice * slotCount + slot] is true if the choice may still be put
+         * into the slot. The domains of unassigned choices are narrowed by forward checking whenever a decision is
+         * made.
+         */
+        vector<bool> domains;
+        vector<int> domainSize;
+
+        /**
+         * The number of unassigned choices whose domain is empty.
+         */
+        int emptyDomainCount = 0;
+
+        /**
+         * All domain removals (choice and slot) in order, and the size of this trail before each decision, so the
+         * removals of a decision can be reverted.
+         */
+        vector<pair<int, int>> trail;
+        vector<size_t> trailMarks;
+
+        /**
+         * The depth of the decision of each assigned choice.
+         */
+        vector<int> depthOf;
+
+        /**
+         * The depth of the decision that removed each slot from the domain of each choice (same layout as domains), or
+         * -1 if it was removed by a unary constraint. Only meaningful for removed slots.
+         */
+        vector<int> removedBy;
+
+        /**
+         * Coverage of the critical sets of the search: the indices of the critical sets containing each choice (shared
+         * with the critical set analysis), the number of unassigned elements of each set, the number of elements of
+         * each set in each slot (the counts of set k start at k * slotCount), and the number of slots containing any
+         * element of each set.
+         */
+        vector<vector<int>> const& setsOfChoice;
+        vector<int> setMissing;
+        vector<int> setSlotHits;
+        vector<int> setCoveredSlots;
+
+        /**
+         * The number of critical sets that can not cover all slots anymore.
+         */
+        int violatedSetCount = 0;
+
+        SearchState(InputData const& inputData,
+                    vector<CriticalSet> const& criticalSets,
+                    vector<vector<int>> const& setsOfChoice);
+    };
+
+    /**
+     * Removes the given slot from the domain of the given choice and records the removal on the trail.
+     */
+    void remove_from_domain(SearchState& state, int choice, int slot);
+
+    /**
+     * Narrows the domains of all choices by their unary constraints (ChoiceIsInSlot, ChoiceIsNotInSlot and the slot
+     * range of ChoicesHaveOffset). These removals are never reverted.
+     */
+    void restrict_root_domains(SearchState& state);
+
+    /**
+     * Learned nogoods for one list of critical sets. A nogood is a list of decisions (choice and slot) that can not all
+     * be part of a scheduling satisfying these critical sets.
+     */
+    struct NogoodStore
+    {
+        vector<vector<pair<int, int>>> nogoods;
+
+        /**
+         * The indices of the nogoods containing each decision, by choice * slotCount + slot.
+         */
+        map<int, vector<int>> byDecision;
+
+        /**
+         * True if the search has proven that there is no scheduling at all.
+         */
+        bool infeasible = false;
+    };
+
+    /**
+     * Learned nogoods by the preference limit of the critical sets they were learned with. They are kept across all
+     * searches of this instance.
+     */
+    map<int, NogoodStore> _nogoods;
+
+    /**
+     * Puts the given (unassigned) choice into the given slot and propagates the ChoicesAreInSameSlot,
+     * ChoicesAreNotInSameSlot and ChoicesHaveOffset constraints of the choice to the domains of the unassigned choices.
+     */
+    void assign(SearchState& state, int choice, int slot);
+
+    /**
+     * Reverts the assignment of the given choice (which has to be the last assigned choice), including its domain
+     * removals.
+     */
+    void unassign(SearchState& state, int choice);
+
+    /**
+     * Adds the depths of all decisions so far to the given conflict set. Used for failures that can not be attributed
+     * to specific decisions.
+     */
+    void add_global_conflict(SearchState const& state, ordered_set<int>& conflict);
+
+    /**
+     * Adds the depths of the decisions that removed slots from the domain of the given choice to the given conflict set.
+     */
+    void add_domain_conflict(SearchState const& state, int choice, ordered_set<int>& conflict);
+
+    /**
+     * Adds the depths of the decisions responsible for excluding the given slot for the given choice (see
+     * satisfies_scheduling_constraints and calculate_feasible_slots) to the given conflict set.
+     */
+    void add_slot_conflict(SearchState const& state, int choice, int slot, ordered_set<int>& conflict);
+
+    /**
+     * Tests if putting the given choice into the given slot would complete any learned nogood. If so, the depths of
+     * the other decisions of the nogood are added to the given conflict set.
+     */
+    bool violates_nogood(SearchState const& state,
+                         NogoodStore const& nogoods,
+                         int choice,
+                         int slot,
+                         ordered_set<int>& conflict);
+
     /**
-     * The available max push is the sum of the maximum chooser counts of all choices that are not yet assigned
-     * to a set (the maximum number of choosers that can be covered with all choices that are not
-     * yet assigned to a set).
+     * Records the decisions at the depths of the given conflict set as a nogood, unless it is too large or the store is
+     * full. An empty conflict set proves that there is no scheduling at all.
      */
-    int calculate_available_max_push(vector<int> const& choiceScramble, int depth);
+    void learn_nogood(SearchState const& state,
+                      NogoodStore& nogoods,
+                      vector<int> const& choiceOrder,
+                      ordered_set<int> const& conflict);
 
     /**
-     * Tests if the current partial solution satisfies all given critical sets.
+     * Updates the critical set coverage of the given search state when the given choice is put into (delta = 1) or
+     * removed from (delta = -1) the given slot.
      */
-    bool satisfies_critical_sets(map<int, int> const& decisions, vector<CriticalSet> const& criticalSets);
+    void update_critical_sets(SearchState& state, int choice, int slot, int delta);
 
     /**
-     * Tests if the hypothetical decision of putting choice into set would violate any scheduling constraints.
+     * Tests if the current partial solution satisfies all given critical sets, which have to be the critical sets the
+     * search state was created with. If not, the depths of the decisions of the elements of a violated critical set
+     * are added to the given conflict set.
      */
-    bool satisfies_scheduling_constraints(int choice, int set, map<int, int> const& decisions);
+    bool satisfies_critical_sets(SearchState const& state,
+                                 vector<CriticalSet> const& criticalSets,
+                                 ordered_set<int>& conflict);
+
+    /**
+     * Tests if the hypothetical decision of putting choice into set would violate any scheduling constraints. All
+     * constraints except SlotHasLimitedSize are already enforced by the slot domain of the choice.
+     */
+    bool satisfies_scheduling_constraints(int choice, int set, SearchState const& state);
 
     /**
      * Checks if the hypothetical decision of putting choice into set would violate any slot size constraints. This
      * method must only be called when the given hypothetical decision will be the last decision before the scheduling
      * is complete.
      */
-    bool check_slot_size_constraints([[maybe_unused]] int choice, int slot, map<int, int> const& decisions);
+    bool check_slot_size_constraints([[maybe_unused]] int choice, int slot, SearchState const& state);
 
     /**
      * Tests if the current partial solution has any impossibilities. Impossibilities are sets that contain so few
      * choices that even with all the choices not yet assigned they would not have enough capacity for all
      * choosers.
      */
-    bool has_impossibilities(map<int, int> const& decisions, int availableMaxPush);
+    bool has_impossibilities(SearchState const& state);
 
     /**
      * Calculates critical sets in the current partial solution that limit the next decision. Critical sets are sets
      * that need the next choice in order to still be able to fulfill the chooser count.
      */
-    vector<int> calculate_critical_sets(map<int, int> const& decisions, int availableMaxPush, int choice);
+    vector<int> calculate_critical_sets(SearchState const& state, int choice);
 
     /**
      * Calculates the score used to decide the order in which sets are preferred when deciding a set for a choice
      * (smaller score means higher priority). Currently, the score is the sum of the maximum chooser counts of all
      * choices in this set.
      */
-    int slot_order_heuristic_score(map<int, int> const& decisions, int set);
+    int slot_order_heuristic_score(SearchState const& state, int set);
 
     /**
      * Calculates the sets that are feasible for the next choice regarding the current partial solution. A set is
      * infeasible if adding the choice would cause the minimum chooser count to exceed the total number of
      * choosers.
      *
+     * The depths of the decisions responsible for the infeasible sets are added to the given conflict set.
+     *
      * @param lowPrioritySet A list of sets that are low priority (they should be tried last while backtracking).
      */
-    vector<int> calculate_feasible_slots(map<int, int> const& decisions, vector<bool> const& lowPrioritySet, int choice);
+    vector<int> calculate_feasible_slots(SearchState const& state,
+                                         vector<bool> const& lowPrioritySet,
+                                         int choice,
+                                         ordered_set<int>& conflict);
 
     /**
-     * Shuffles the list of choices to randomize the solutions found first. Currently, only auto-generated sets for
-     * unscheduled choices are low priority.
-     * @return
+     * Shuffles the list of choices to randomize the solutions found first. Choices with more scheduling constraints
+     * come first. This order breaks ties of the smallest-domain-first choice ordering.
      */
     vector<int> get_choice_scramble();
 
+    /**
+     * Returns the unassigned choice with the smallest slot domain. Ties are broken by the order of the choice scramble.
+     */
+    int next_choice(SearchState const& state, vector<int> const& choiceScramble);
+
     /**
      * Generates a vector v where v[n]=true means that n is a low-priority slot.
      */
     vector<bool> get_low_priority_slots();
 
     /**
-     * Transforms the decision map into list of lists d, where d[n] is the list of choices assigned to set n.
+     * Transforms the (complete) search state into list of lists d, where d[n] is the list of choices assigned to set n.
      */
-    vector<vector<int>> convert_decisions(map<int, int> const& decisions);
+    vector<vector<int>> convert_decisions(SearchState const& state);
 
     /**
-     * Solves a scheduling. If the timeLimit is reached, an empty vector is returned.
+     * Solves a scheduling. If the timeLimit is reached, an empty vector is returned. When all options of a decision are
+     * exhausted, the search jumps back to the deepest decision responsible for the failure (conflict-directed
+     * backjumping) and records the responsible decisions in the given nogood store, which has to belong to the given
+     * critical sets. The critical sets of each choice have to be given as returned by
+     * CriticalSetAnalysis::sets_of_choice.
      */
-    vector<vector<int>> solve_scheduling(vector<CriticalSet> const& criticalSets, datetime timeLimit);
+    vector<vector<int>> solve_scheduling(vector<CriticalSet> const& criticalSets,
+                                         vector<vector<int>> const& setsOfChoice,
+                                         NogoodStore& nogoods,
+                                         datetime timeLimit);
 
 public:
     /**
@@ -120,6 +314,16 @@ public:
      */
     inline static const int PREF_RELAXATION = 10;
 
+    /**
+     * Nogoods with more decisions than this are not recorded, since they would rarely prune anything.
+     */
+    inline static const int MAX_NOGOOD_SIZE = 12;
+
+    /**
+     * The maximum number of nogoods recorded per list of critical sets.
+     */
+    inline static const int MAX_NOGOODS = 100000;
+
     /**
      * Constructor.
      */
@@ -148,4 +352,22 @@ public:
     {
         return _hasSolution;
     }
+
+    /**
+     * Returns the number of backtracking searches started by this instance so far. Searches for critical sets that
+     * were already proven infeasible are not started.
+     */
+    [[nodiscard]] int search_count() const;
+
+    /**
+     * Returns the number of decision levels that were skipped by backjumps so far, because their decisions were not
+     * responsible for the failure.
+     */
+    [[nodiscard]] int skipped_level_count() const;
+
+    /**
+     * Returns the number of slot options that were discarded so far because they would have completed a learned
+     * nogood.
+     */
+    [[nodiscard]] int nogood_prune_count() const;
 };
@@ -17,6 +17,7 @@
 #include "Scoring.h"
 
 #include <cmath>
+#include <climits>
 
 #include "Util.h"
 
@@ -223,3 +224,73 @@ Score Scoring::evaluate(Solution const& solution) const
         return {.major = INFINITY, .minor = INFINITY};
     }
 }
+
+Score Scoring::lower_bound(Scheduling const& scheduling) const
+{
+    vector<bool> allowed(_inputData->chooser_count() * _inputData->choice_count(), true);
+
+    for(Constraint const& constraint : _inputData->assignment_constraints())
+    {
+        int p = constraint.left();
+
+        switch(constraint.type())
+        {
+            case ChooserIsInChoice:
+            {
+                for(int w = 0; w < _inputData->choice_count(); w++)
+                {
+                    if(w != constraint.right() && scheduling.slot_of(w) == scheduling.slot_of(constraint.right()))
+                    {
+                        allowed[p * _inputData->choice_count() + w] = false;
+                    }
+                }
+                break;
+            }
+            case ChooserIsNotInChoice:
+            {
+                allowed[p * _inputData->choice_count() + constraint.right()] = false;
+                break;
+            }
+            default: break;
+        }
+    }
+
+    vector<int> prefCount(_inputData->max_preference() + 1);
+    int major = 0;
+
+    for(int p = 0; p < _inputData->chooser_count(); p++)
+    {
+        vector<int> bestPref(_inputData->slot_count(), INT_MAX);
+
+        for(int w = 0; w < _inputData->choice_count(); w++)
+        {
+            if(!allowed[p * _inputData->choice_count() + w]) continue;
+
+            int& pref = bestPref[scheduling.slot_of(w)];
+            pref = std::min(pref, _inputData->chooser(p).preferences[w]);
+        }
+
+        for(int s = 0; s < _inputData->slot_count(); s++)
+        {
+            if(bestPref[s] == INT_MAX)
+            {
+                return {.major = INFINITY, .minor = INFINITY};
+            }
+
+            prefCount[bestPref[s]]++;
+            major = std::max(major, bestPref[s]);
+        }
+    }
+
+    float sum = 0;
+    for(int pref = 0; pref <= _inputData->max_preference(); pref++)
+    {
+        sum += prefCount[pref] * std::pow((float)pref, (float)_options->preference_exponent()) / _scaling;
+    }
+
+    // The sum is calculated in a different order than in evaluate_minor, so we leave some room for rounding errors.
+    //
+    sum *= 1.0f - 1e-5f;
+
+    return {.major = _options->greedy() ? NAN : (float)major, .minor = sum};
+}
@@ -54,6 +54,13 @@ public:
      * Calculates the score of the given solution.
      */
     [[nodiscard]] virtual Score evaluate(Solution const& solution) const;
+
+    /**
+     * Calculates a lower bound for the score of every solution with the given scheduling without solving the
+     * assignment. The bound assumes that every chooser gets their best choice (respecting ChooserIsInChoice and
+     * ChooserIsNotInChoice constraints) in every slot.
+     */
+    [[nodiscard]] virtual Score lower_bound(Scheduling const& scheduling) const;
 };
 
 
@@ -32,13 +32,16 @@ ShotgunSolver::ShotgunSolver(const_ptr<InputData> inputData,
                              const_ptr<MipFlowStaticData> const& staticData,
                              const_ptr<Scoring> scoring,
                              const_ptr<Options> options,
-                             cancel_token cancellation)
+                             cancel_token cancellation,
+                             shared_ptr<AssignmentCache> assignmentCache,
+                             shared_ptr<ThreadBudget> threadBudget)
     : _inputData(std::move(inputData)),
     _options(std::move(options)),
     _cancellation(std::move(cancellation)),
     _scoring(std::move(scoring))
 {
-    _hillClimbingSolver = std::make_unique<HillClimbingSolver>(_inputData, csAnalysis, staticData, _scoring, _options, _cancellation);
+    _hillClimbingSolver = std::make_unique<HillClimbingSolver>(_inputData, csAnalysis, staticData, _scoring, _options, _cancellation,
+                                                               std::move(assignmentCache), std::move(threadBudget));
     _schedulingSolver = std::make_unique<SchedulingSolver>(_inputData, csAnalysis, _options, _cancellation);
 
     _progress.best_score = {.major = INFINITY, .minor = INFINITY};
@@ -77,5 +80,6 @@ ShotgunSolverProgress const& ShotgunSolver::progress()
 {
     _progress.assignments = _hillClimbingSolver->assignment_count();
     _progress.lp = _hillClimbingSolver->lp_count();
+    _progress.pruned = _hillClimbingSolver->pruned_count();
     return _progress;
 }
@@ -33,6 +33,7 @@ struct ShotgunSolverProgress
     int iterations = 0;
     int assignments = 0;
     int lp = 0;
+    int pruned = 0;
     Solution best_solution = Solution::invalid();
     Score best_score = {.major = INFINITY, .minor = INFINITY};
 };
@@ -62,7 +63,9 @@ public:
                   const_ptr<MipFlowStaticData> const& staticData,
                   const_ptr<Scoring> scoring,
                   const_ptr<Options> options,
-                  cancel_token cancellation = cancel_token());
+                  cancel_token cancellation = cancel_token(),
+                  shared_ptr<AssignmentCache> assignmentCache = nullptr,
+                  shared_ptr<ThreadBudget> threadBudget = nullptr);
 
     [[nodiscard]] Solution current_solution() const;
 
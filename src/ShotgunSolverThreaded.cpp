@@ -17,6 +17,7 @@
 #include "ShotgunSolverThreaded.h"
 
 #include <utility>
+#include <thread>
 
 long ShotgunSolverThreadedProgress::getMillisecondsRemaining() const
 {
@@ -48,6 +49,31 @@ int ShotgunSolverThreadedProgress::getLp() const
     return lp;
 }
 
+int ShotgunSolverThreadedProgress::getPruned() const
+{
+    return pruned;
+}
+
+long ShotgunSolverThreadedProgress::getCacheHits() const
+{
+    return cache_hits;
+}
+
+long ShotgunSolverThreadedProgress::getCacheMisses() const
+{
+    return cache_misses;
+}
+
+int ShotgunSolverThreadedProgress::getOuterThreads() const
+{
+    return outer_threads;
+}
+
+int ShotgunSolverThreadedProgress::getInnerThreads() const
+{
+    return inner_threads;
+}
+
 ShotgunSolverThreaded::ShotgunSolverThreaded(const_ptr<InputData> inputData,
                                              const_ptr<CriticalSetAnalysis> csAnalysis,
                                              const_ptr<MipFlowStaticData> staticData,
@@ -59,18 +85,35 @@ ShotgunSolverThreaded::ShotgunSolverThreaded(const_ptr<InputData> inputData,
     _staticData(std::move(staticData)),
     _scoring(std::move(scoring))
 {
+    if(_options->cache_size() > 0)
+    {
+        _assignmentCache = std::make_shared<AssignmentCache>(_inputData, (size_t)_options->cache_size() * 1024 * 1024);
+    }
 }
 
 void ShotgunSolverThreaded::thread_loop(int tid, cancel_token cancellation)
 {
     _threadStartTimes[tid] = time_now();
     _threadSolvers[tid] = std::make_unique<ShotgunSolver>(_inputData, _csAnalysis, _staticData, _scoring, _options,
-                                                          std::move(cancellation));
+                                                          cancellation, _assignmentCache, _threadBudget);
 
     datetime startTime = time_now();
 
     while (startTime + seconds(_options->timeout_seconds()) > time_now())
     {
+        // Threads beyond the thread budget pause, so the active threads can use their cores for inner parallelism.
+        //
+        if(!_threadBudget->is_active(tid))
+        {
+            if(is_set(cancellation))
+            {
+                break;
+            }
+
+            std::this_thread::sleep_for(milliseconds(10));
+            continue;
+        }
+
         int iterationsDone = _threadSolvers[tid]->iterate();
 
         if(_inputData->slot_count() == 1 || iterationsDone < 1)
@@ -126,6 +169,10 @@ void ShotgunSolverThreaded::start()
     _cancellationSource = cancel_token_source();
     auto cancellation = _cancellationSource.get_future().share();
 
+    _threadBudget = std::make_shared<ThreadBudget>(
+            std::max((int)std::thread::hardware_concurrency(), numThreads),
+            numThreads);
+
     for(int tid = 0; tid < numThreads; tid++)
     {
         _threadStartTimes[tid] = time_never();
@@ -200,6 +247,19 @@ ShotgunSolverThreadedProgress ShotgunSolverThreaded::progress() const
         progress.iterations += threadProgress.iterations;
         progress.assignments += threadProgress.assignments;
         progress.lp += threadProgress.lp;
+        progress.pruned += threadProgress.pruned;
+    }
+
+    if(_threadBudget != nullptr)
+    {
+        progress.outer_threads = _threadBudget->outer_threads();
+        progress.inner_threads = _threadBudget->inner_threads();
+    }
+
+    if(_assignmentCache != nullptr)
+    {
+        progress.cache_hits = _assignmentCache->hits();
+        progress.cache_misses = _assignmentCache->misses();
     }
 
     return progress;
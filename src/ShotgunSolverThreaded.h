@@ -25,11 +25,20 @@
 struct ShotgunSolverThreadedProgress : ShotgunSolverProgress
 {
     long milliseconds_remaining = 0;
+    long cache_hits = 0;
+    long cache_misses = 0;
+    int outer_threads = 0;
+    int inner_threads = 0;
 
     [[nodiscard]] long getMillisecondsRemaining() const;
     [[nodiscard]] int getIterations() const;
     [[nodiscard]] int getAssignments() const;
     [[nodiscard]] int getLp() const;
+    [[nodiscard]] int getPruned() const;
+    [[nodiscard]] long getCacheHits() const;
+    [[nodiscard]] long getCacheMisses() const;
+    [[nodiscard]] int getOuterThreads() const;
+    [[nodiscard]] int getInnerThreads() const;
     [[nodiscard]] Solution getBestSolution() const;
     [[nodiscard]] Score getBestScore() const;
 };
@@ -55,6 +64,9 @@ private:
     const_ptr<MipFlowStaticData> _staticData;
     const_ptr<Scoring> _scoring;
 
+    shared_ptr<AssignmentCache> _assignmentCache;
+    shared_ptr<ThreadBudget> _threadBudget;
+
     vector<pthread_t> _threads;
     vector<unique_ptr<ShotgunSolver>> _threadSolvers;
     vector<datetime> _threadStartTimes;
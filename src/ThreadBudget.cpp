@@ -0,0 +1,65 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadBudget.h"
+
+ThreadBudget::ThreadBudget(int coreCount, int maxOuterThreads)
+    : _coreCount(std::max(1, coreCount)),
+    _maxOuterThreads(std::max(1, maxOuterThreads)),
+    _outerThreads(std::max(1, maxOuterThreads))
+{
+}
+
+void ThreadBudget::report_solve(nanoseconds duration)
+{
+    std::lock_guard lock(_windowMutex);
+
+    _windowDuration += duration;
+    _windowSolves++;
+
+    if(_windowSolves < WINDOW_SIZE) return;
+
+    // Long solves profit from inner parallelism, so the outer threads are halved; with short solves, the overhead of
+    // inner threads does not pay off, so the outer threads are doubled again.
+    //
+    auto average = _windowDuration / _windowSolves;
+    if(average > SLOW_SOLVE)
+    {
+        _outerThreads = std::max(1, _outerThreads / 2);
+    }
+    else if(average < FAST_SOLVE)
+    {
+        _outerThreads = std::min(_maxOuterThreads, _outerThreads * 2);
+    }
+
+    _windowDuration = nanoseconds(0);
+    _windowSolves = 0;
+}
+
+bool ThreadBudget::is_active(int outerThread) const
+{
+    return outerThread < _outerThreads;
+}
+
+int ThreadBudget::outer_threads() const
+{
+    return _outerThreads;
+}
+
+int ThreadBudget::inner_threads() const
+{
+    return std::max(1, _coreCount / _outerThreads);
+}
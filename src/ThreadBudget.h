@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "Types.h"
+
+#include <mutex>
+
+/**
+ * Splits the available cores between the outer solver threads (each running its own shotgun hill climbing) and the
+ * inner threads each of them may use for a single assignment solve (parallel slot solves and MIP solver threads). A
+ * single instance is shared by all solver threads.
+ *
+ * The split adapts to the observed assignment solve times: if solves take long, fewer outer threads are active and
+ * every solve gets more inner threads; if solves are fast, all outer threads are active with a single inner thread.
+ */
+class ThreadBudget
+{
+private:
+    static const int WINDOW_SIZE = 64;
+    inline static const nanoseconds SLOW_SOLVE = milliseconds(100);
+    inline static const nanoseconds FAST_SOLVE = milliseconds(10);
+
+    int _coreCount;
+    int _maxOuterThreads;
+    atomic<int> _outerThreads;
+
+    std::mutex _windowMutex;
+    nanoseconds _windowDuration = nanoseconds(0);
+    int _windowSolves = 0;
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param coreCount The number of available cores.
+     * @param maxOuterThreads The number of outer solver threads; initially, all of them are active.
+     */
+    ThreadBudget(int coreCount, int maxOuterThreads);
+
+    /**
+     * Records the duration of a single assignment solve. Every few solves, the split is adjusted to the average
+     * duration.
+     */
+    void report_solve(nanoseconds duration);
+
+    /**
+     * Returns true if the outer thread with the given index should currently run. Inactive threads should wait until
+     * they are active again.
+     */
+    [[nodiscard]] bool is_active(int outerThread) const;
+
+    /**
+     * Returns the number of currently active outer threads.
+     */
+    [[nodiscard]] int outer_threads() const;
+
+    /**
+     * Returns the number of inner threads every active outer thread may use.
+     */
+    [[nodiscard]] int inner_threads() const;
+};
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "WorkerPool.h"
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+
+    _jobCondition.notify_all();
+    for(std::thread& thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::work(int worker)
+{
+    std::unique_lock lock(_mutex);
+    long seenJobs = 0;
+
+    while(true)
+    {
+        // A thread started for the current job has not seen it yet, so it takes part in it right away.
+        //
+        _jobCondition.wait(lock, [&] { return _stop || _jobCount != seenJobs; });
+        if(_stop) return;
+
+        seenJobs = _jobCount;
+        if(worker >= _jobWorkers) continue;
+
+        lock.unlock();
+        std::exception_ptr exception;
+        try
+        {
+            (*_job)(worker);
+        }
+        catch(...)
+        {
+            exception = std::current_exception();
+        }
+        lock.lock();
+
+        if(exception != nullptr && _exception == nullptr) _exception = exception;
+        if(--_runningWorkers == 0) _doneCondition.notify_all();
+    }
+}
+
+void WorkerPool::run(int workers, std::function<void(int)> const& job)
+{
+    {
+        std::lock_guard lock(_mutex);
+        while(_threads.size() < workers - 1)
+        {
+            int worker = _threads.size() + 1;
+            _threads.emplace_back([this, worker] { work(worker); });
+        }
+
+        _job = &job;
+        _jobWorkers = workers;
+        _runningWorkers = workers - 1;
+        _jobCount++;
+        _exception = nullptr;
+    }
+
+    _jobCondition.notify_all();
+
+    std::exception_ptr exception;
+    try
+    {
+        job(0);
+    }
+    catch(...)
+    {
+        exception = std::current_exception();
+    }
+
+    std::unique_lock lock(_mutex);
+    _doneCondition.wait(lock, [&] { return _runningWorkers == 0; });
+    _job = nullptr;
+
+    if(exception == nullptr) exception = _exception;
+    if(exception != nullptr) std::rethrow_exception(exception);
+}
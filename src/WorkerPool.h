@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "Types.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/**
+ * A set of threads that run the workers of a parallel job. The threads are started on first use and kept for all later
+ * jobs, so a job does not pay for starting threads. A pool only runs one job at a time.
+ */
+class WorkerPool
+{
+private:
+    vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _jobCondition;
+    std::condition_variable _doneCondition;
+    std::function<void(int)> const* _job = nullptr;
+    int _jobWorkers = 0;
+    int _runningWorkers = 0;
+    long _jobCount = 0;
+    bool _stop = false;
+    std::exception_ptr _exception;
+
+    /**
+     * The loop of the thread running the given worker of every job.
+     */
+    void work(int worker);
+
+public:
+    /**
+     * Constructor.
+     */
+    WorkerPool() = default;
+
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator = (WorkerPool const&) = delete;
+
+    ~WorkerPool();
+
+    /**
+     * Calls the given function once for every worker from 0 to workers - 1, concurrently. Worker 0 runs on the calling
+     * thread, the others on the threads of this pool. Returns when all workers are done; if a worker threw an
+     * exception, it is rethrown here.
+     */
+    void run(int workers, std::function<void(int)> const& job);
+};
@@ -107,13 +107,56 @@ void track_progress(ShotgunSolverThreaded& solver)
             string scoreStr = progress.getBestScore().is_finite() ? "Best score: " + progress.getBestScore().to_str() : "No solution yet";
             Status::info("[Status] " + scoreStr
             + "; Time remaining: " + str(milliseconds(progress.getMillisecondsRemaining()))
-            + "; Iterations (A/L): " + str(progress.getIterations()) + " (" + str(progress.getAssignments()) + "/" + str(progress.getLp()) + ")");
+            + "; Iterations (A/L): " + str(progress.getIterations()) + " (" + str(progress.getAssignments()) + "/" + str(progress.getLp()) + ")"
+            + "; Pruned: " + str(progress.getPruned())
+            + "; Cache (H/M): " + str(progress.getCacheHits()) + "/" + str(progress.getCacheMisses())
+            + "; Threads (O/I): " + str(progress.getOuterThreads()) + "/" + str(progress.getInnerThreads()));
             lastOutput = time_now();
         }
         std::this_thread::sleep_for(milliseconds(5));
     }
 }
 
+void compare_backends(const_ptr<InputData> const& inputData,
+                      const_ptr<CriticalSetAnalysis> const& csAnalysis,
+                      const_ptr<MipFlowStaticData> const& staticData,
+                      const_ptr<Scoring> const& scoring,
+                      const_ptr<Options> const& options)
+{
+    SchedulingSolver schedulingSolver(inputData, csAnalysis, options);
+    if(!schedulingSolver.next_scheduling())
+    {
+        Status::error("No scheduling found to compare the assignment backends on.");
+        return;
+    }
+
+    auto scheduling = schedulingSolver.scheduling();
+
+    for(AssignmentBackend backend : {NativeBackend, CbcBackend, CpSatBackend, GlopBackend})
+    {
+        string name = Options::assignment_backend_name(backend);
+
+        if(!MipFlow::is_supported(backend))
+        {
+            Status::info_important("[Backend] " + name + ": Not available.");
+            continue;
+        }
+
+        auto backendOptions = std::make_shared<Options>(*options);
+        backendOptions->set_assignment_backend(backend);
+        AssignmentSolver assignmentSolver(inputData, csAnalysis, staticData, backendOptions);
+
+        auto startTime = time_now();
+        auto assignment = assignmentSolver.solve(scheduling);
+        auto elapsed = time_now() - startTime;
+
+        string scoreStr = assignment == nullptr
+                ? "No solution"
+                : "Score: " + scoring->evaluate(Solution(scheduling, assignment)).to_str();
+        Status::info_important("[Backend] " + name + ": " + str(elapsed) + " (" + scoreStr + ")");
+    }
+}
+
 int main(int argc, char** argv)
 {
     set_signal_handler(SIGINT, signal_handler);
@@ -171,8 +214,22 @@ int main(int argc, char** argv)
             Status::info("Critical set analysis gives a preference bound of " + str(csAnalysis->preference_bound()) + ".");
         }
 
+        if(!MipFlow::is_supported(options->assignment_backend()))
+        {
+            Status::error("The assignment backend " + Options::assignment_backend_name(options->assignment_backend())
+                          + " is not available in this build.");
+            return 1;
+        }
+
         Status::info("Generating static data and starting solver.");
         auto staticData = std::make_shared<MipFlowStaticData>(inputData);
+
+        if(options->compare_backends())
+        {
+            compare_backends(inputData, csAnalysis, staticData, scoring, options);
+            return 0;
+        }
+
         ShotgunSolverThreaded solver(inputData, csAnalysis, staticData, scoring, options);
         solver.start();
 
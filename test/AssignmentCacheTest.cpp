@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "inputs/minimal.h"
+#include "../src/AssignmentCache.h"
+
+#define PREFIX "[AssignmentCache] "
+
+TEST_CASE(PREFIX "Returns cached assignments and counts hits and misses")
+{
+    auto data = parse_data(INPUT_MINIMAL);
+    AssignmentCache cache(data, 1024 * 1024);
+
+    Scheduling scheduling(data, {0});
+    auto assignment = std::make_shared<Assignment const>(data, vector<vector<int>>{{0}});
+
+    const_ptr<Assignment const> result;
+    REQUIRE_FALSE(cache.try_get(scheduling, result));
+
+    cache.insert(scheduling, assignment);
+    REQUIRE(cache.try_get(Scheduling(data, {0}), result));
+    REQUIRE(result == assignment);
+
+    cache.insert(Scheduling(data, {1}), nullptr);
+    REQUIRE(cache.try_get(Scheduling(data, {1}), result));
+    REQUIRE(result == nullptr);
+
+    REQUIRE(cache.hits() == 2);
+    REQUIRE(cache.misses() == 1);
+}
+
+TEST_CASE(PREFIX "Evicts the oldest entries of a shard first")
+{
+    auto data = parse_data(INPUT_MINIMAL);
+    AssignmentCache cache(data, 64 * 1024);
+
+    size_t entriesPerShard = cache.capacity() / AssignmentCache::SHARD_COUNT;
+    int insertCount = 4 * cache.capacity();
+
+    for(int i = 0; i < insertCount; i++)
+    {
+        cache.insert(Scheduling(data, {i}), nullptr);
+    }
+
+    // An entry has to be present exactly if fewer entries than the shard capacity were inserted into its shard after
+    // it.
+    //
+    vector<size_t> laterInserts(AssignmentCache::SHARD_COUNT, 0);
+    for(int i = insertCount - 1; i >= 0; i--)
+    {
+        Scheduling scheduling(data, {i});
+        size_t& later = laterInserts[AssignmentCache::shard_index(scheduling)];
+
+        const_ptr<Assignment const> result;
+        REQUIRE(cache.try_get(scheduling, result) == (later < entriesPerShard));
+
+        later++;
+    }
+}
@@ -17,8 +17,10 @@
 #include "common.h"
 #include "inputs/minimal.h"
 #include "inputs/big_realistic.h"
+#include "inputs/two_slots.h"
 #include "../src/AssignmentSolver.h"
 #include <cstdio>
+#include <thread>
 
 #define PREFIX "[AssignmentSolver] "
 
@@ -166,4 +168,308 @@ TEST_CASE(PREFIX "Constraint ChoosersHaveSameChoices works")
     auto assignment = solver.solve(scheduling);
 
     expect_assignment(sol(scheduling, assignment), "p1,c1,c3;p2,c2,c4;p3,c2,c4;p4,c1,c3");
-}
\ No newline at end of file
+}
+
+TEST_CASE(PREFIX "Incremental solve matches full solve")
+{
+    auto data = parse_data(INPUT_TWO_SLOTS + R"(
++constraint(chooser("p1").choices.contains_not(choice("c3")));
+)");
+
+    auto options = default_options();
+    AssignmentSolver fullSolver(data, csa(data, false), sd(data), options);
+    AssignmentSolver incrementalSolver(data, csa(data, false), sd(data), options);
+
+    auto parent = MAKE_SCHED(data, (vector<int> {0, 0, 1, 1}));
+    auto neighbor = MAKE_SCHED(data, (vector<int> {0, 1, 1, 0}));
+
+    auto fullSolution = sol(neighbor, fullSolver.solve(neighbor));
+    auto incrementalSolution = sol(neighbor, incrementalSolver.solve(neighbor, parent));
+
+    REQUIRE(scoring(data, options)->evaluate(fullSolution) == scoring(data, options)->evaluate(incrementalSolution));
+}
+
+TEST_CASE(PREFIX "Lexicographic solve matches binary search")
+{
+    auto data = parse_data(INPUT_TWO_SLOTS + R"(
++constraint(chooser("p1").choices == chooser("p2").choices);
+)");
+
+    auto options = default_options();
+    auto lexicographicOptions = std::make_shared<Options>(*options);
+    lexicographicOptions->set_lexicographic(true);
+
+    AssignmentSolver searchSolver(data, csa(data, false), sd(data), options);
+    AssignmentSolver lexicographicSolver(data, csa(data, false), sd(data), lexicographicOptions);
+
+    for(auto const& raw : vector<vector<int>> {{0, 0, 1, 1}, {0, 1, 1, 0}, {0, 1, 0, 1}})
+    {
+        auto scheduling = MAKE_SCHED(data, raw);
+        auto searchSolution = sol(scheduling, searchSolver.solve(scheduling));
+
+        int lpCount = lexicographicSolver.lp_count();
+        auto lexicographicSolution = sol(scheduling, lexicographicSolver.solve(scheduling));
+
+        REQUIRE(scoring(data, options)->evaluate(searchSolution)
+                == scoring(data, options)->evaluate(lexicographicSolution));
+
+        // The constraint makes the slots dependent, so the lexicographic solve replaces the search on the MIP path:
+        // one solve with lexicographic costs to find the limit and one with the regular costs at this limit.
+        //
+        REQUIRE(lexicographicSolver.last_probe_count() == 1);
+        REQUIRE(lexicographicSolver.lp_count() - lpCount == 2);
+    }
+}
+
+TEST_CASE(PREFIX "All available backends yield the same score")
+{
+    auto options = default_options();
+    auto schedulings = vector<vector<int>> {{0, 0, 1, 1}, {0, 1, 1, 0}, {0, 1, 0, 1}};
+
+    // Without constraints, the assignments are plain min cost flows; the constraint adds edge groups.
+    //
+    for(auto const& input : {INPUT_TWO_SLOTS, INPUT_TWO_SLOTS + R"(
++constraint(chooser("p1").choices == chooser("p2").choices);
+)"})
+    {
+        auto data = parse_data(input);
+        AssignmentSolver autoSolver(data, csa(data, false), sd(data), options);
+
+        for(AssignmentBackend backend : {NativeBackend, CbcBackend, GlopBackend, CpSatBackend})
+        {
+            if(!MipFlow::is_supported(backend)) continue;
+
+            auto backendOptions = std::make_shared<Options>(*options);
+            backendOptions->set_assignment_backend(backend);
+            AssignmentSolver backendSolver(data, csa(data, false), sd(data), backendOptions);
+
+            for(auto const& raw : schedulings)
+            {
+                auto scheduling = MAKE_SCHED(data, raw);
+                auto autoSolution = sol(scheduling, autoSolver.solve(scheduling));
+                auto backendSolution = sol(scheduling, backendSolver.solve(scheduling));
+
+                REQUIRE(scoring(data, options)->is_feasible(backendSolution));
+                REQUIRE(scoring(data, options)->evaluate(autoSolution)
+                        == scoring(data, options)->evaluate(backendSolution));
+            }
+        }
+    }
+}
+
+TEST_CASE(PREFIX "Concurrent slot solves match the coupled solve")
+{
+    // The slots are only solved concurrently if they are large enough, so the input has many distinct choosers.
+    //
+    string input = "+slot(\"s1\");\n+slot(\"s2\");\n+slot(\"s3\");\n";
+    for(int w = 0; w < 30; w++)
+    {
+        input += "+choice(\"c" + str(w) + "\", bounds(0, 40));\n";
+    }
+
+    unsigned int seed = 1;
+    for(int p = 0; p < 300; p++)
+    {
+        input += "+chooser(\"p" + str(p) + "\", [";
+        for(int w = 0; w < 30; w++)
+        {
+            seed = seed * 1103515245 + 12345;
+            input += (w > 0 ? ", " : "") + str((seed >> 16) % 11 * 10);
+        }
+
+        input += "]);\n";
+    }
+
+    auto data = parse_data(input);
+
+    // A chooser that has to have the same choices as itself changes nothing but makes the problem non-decomposable.
+    //
+    auto coupledData = parse_data(input + "+constraint(chooser(\"p0\").choices == chooser(\"p0\").choices);\n");
+
+    auto options = default_options();
+    AssignmentSolver decomposedSolver(data, csa(data, false), sd(data), options, cancel_token(),
+                                      std::make_shared<ThreadBudget>(4, 1));
+    AssignmentSolver coupledSolver(coupledData, csa(coupledData, false), sd(coupledData), options);
+
+    vector<int> raw(30);
+    for(int w = 0; w < 30; w++)
+    {
+        raw[w] = w % 3;
+    }
+
+    // The worker threads are kept between solves, so the second solve reuses them.
+    //
+    for(int i = 0; i < 2; i++)
+    {
+        auto decomposedScheduling = MAKE_SCHED(data, raw);
+        auto coupledScheduling = MAKE_SCHED(coupledData, raw);
+        auto decomposedSolution = sol(decomposedScheduling, decomposedSolver.solve(decomposedScheduling));
+        auto coupledSolution = sol(coupledScheduling, coupledSolver.solve(coupledScheduling));
+
+        REQUIRE(scoring(data, options)->is_feasible(decomposedSolution));
+        REQUIRE(scoring(data, options)->evaluate(decomposedSolution)
+                == scoring(coupledData, options)->evaluate(coupledSolution));
+
+        std::rotate(raw.begin(), raw.begin() + 1, raw.end());
+    }
+}
+
+TEST_CASE(PREFIX "Slot dual values price the assigned choices lowest")
+{
+    // In s1, p1 and p2 both want c1, which only has room for one of them.
+    //
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++choice("c1", bounds(0, 1));
++choice("c2", bounds(0, 2));
++choice("c3", bounds(0, 2));
++choice("c4", bounds(0, 2));
++chooser("p1", [100, 0, 50, 0]);
++chooser("p2", [100, 100, 0, 0]);
++chooser("p3", [0, 100, 100, 0]);
+)");
+
+    for(AssignmentBackend backend : {NativeBackend, GlopBackend})
+    {
+        if(!MipFlow::is_supported(backend)) continue;
+
+        auto options = default_options();
+        options->set_assignment_backend(backend);
+        AssignmentSolver assignmentSolver(data, csa(data, false), sd(data), options);
+
+        auto scheduling = MAKE_SCHED(data, (vector<int> {0, 1, 0, 1}));
+        auto assignment = assignmentSolver.solve(scheduling);
+        auto slotDuals = assignmentSolver.slot_duals(*assignment);
+        REQUIRE(slotDuals.size() == 2);
+
+        // The assignment is optimal, so no chooser can improve by switching to another choice of the same slot within
+        // the preference limit.
+        //
+        for(int p = 0; p < data->chooser_count(); p++)
+        {
+            for(int s = 0; s < data->slot_count(); s++)
+            {
+                double assignedCost = assignmentSolver.reduced_cost(*slotDuals[s], p, assignment->choice_of(p, s));
+
+                for(int w = 0; w < data->choice_count(); w++)
+                {
+                    if(scheduling->slot_of(w) != s) continue;
+                    if(data->chooser(p).preferences[w] > assignment->max_used_preference()) continue;
+
+                    REQUIRE(assignmentSolver.reduced_cost(*slotDuals[s], p, w) > assignedCost - 1e-6);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(PREFIX "Preference limit hint does not change the result")
+{
+    auto data = parse_data(INPUT_TWO_SLOTS + R"(
++constraint(chooser("p1").choices == chooser("p2").choices);
+)");
+
+    auto options = default_options();
+    AssignmentSolver solver(data, csa(data, false), sd(data), options);
+
+    for(auto const& raw : vector<vector<int>> {{0, 0, 1, 1}, {0, 1, 1, 0}, {0, 1, 0, 1}})
+    {
+        auto scheduling = MAKE_SCHED(data, raw);
+        auto solution = sol(scheduling, solver.solve(scheduling));
+        int bottleneck = solution.assignment()->max_used_preference();
+
+        for(int hint : {0, 50, 70, 100})
+        {
+            auto hintedSolution = sol(scheduling, solver.solve(scheduling, nullptr, hint));
+
+            REQUIRE(scoring(data, options)->evaluate(solution) == scoring(data, options)->evaluate(hintedSolution));
+        }
+
+        solver.solve(scheduling, nullptr, bottleneck);
+        REQUIRE(solver.last_probe_count() <= 2);
+    }
+}
+
+TEST_CASE(PREFIX "Choosers with equal preferences share a class")
+{
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++choice("c1", bounds(1, 3));
++choice("c2", bounds(1, 3));
++choice("c3", bounds(1, 3));
++choice("c4", bounds(1, 3));
++chooser("p1", [100, 0, 100, 50]);
++chooser("p2", [100, 0, 100, 50]);
++chooser("p3", [100, 0, 100, 50]);
++chooser("p4", [0, 100, 50, 100]);
++chooser("p5", [0, 100, 50, 100]);
+
++constraint(chooser("p5").choices.contains(choice("c1")));
+)");
+
+    auto staticData = sd(data);
+    REQUIRE(staticData->chooserClasses.size() == 3);
+
+    AssignmentSolver solver(data, csa(data, false), staticData, default_options());
+    auto scheduling = MAKE_SCHED(data, (vector<int> {0, 0, 1, 1}));
+    auto solution = sol(scheduling, solver.solve(scheduling));
+
+    REQUIRE(scoring(data, default_options())->is_feasible(solution));
+    REQUIRE(solution.assignment()->is_in_choice(4, 0));
+}
+
+TEST_CASE(PREFIX "Cancelled solve is reported as interrupted")
+{
+    auto data = parse_data(INPUT_MINIMAL);
+
+    cancel_token_source cancellationSource;
+    cancel_token cancellation = cancellationSource.get_future().share();
+    cancellationSource.set_value();
+
+    AssignmentSolver solver(data, csa(data), sd(data), default_options(), cancellation);
+    auto assignment = solver.solve(MAKE_SCHED(data, 0));
+
+    REQUIRE(assignment == nullptr);
+    REQUIRE(solver.interrupted());
+}
+
+TEST_CASE(PREFIX "Cancelling a running MIP solve interrupts it")
+{
+    // The same-choices constraints create edge groups, so the assignment is solved by the MIP solver.
+    //
+    auto data = parse_data(INPUT_BIG_REALISTIC + R"(
++constraint(chooser("h0").choices == chooser("h1").choices);
++constraint(chooser("h2").choices == chooser("h3").choices);
++constraint(chooser("h4").choices == chooser("h5").choices);
++constraint(chooser("h6").choices == chooser("h7").choices);
+)");
+
+    cancel_token_source cancellationSource;
+    cancel_token cancellation = cancellationSource.get_future().share();
+
+    AssignmentSolver solver(data, csa(data, false), sd(data), default_options(), cancellation);
+    auto scheduling = MAKE_SCHED(data, SCHEDULING_BIG_REALISTIC);
+
+    datetime cancelTime;
+    std::thread canceller([&]
+    {
+        std::this_thread::sleep_for(milliseconds(20));
+        cancelTime = time_now();
+        cancellationSource.set_value();
+    });
+
+    auto assignment = solver.solve(scheduling);
+    datetime finishTime = time_now();
+    canceller.join();
+
+    // If the solve was still running when the token was set, it has to stop soon after and report the interruption.
+    //
+    if(finishTime > cancelTime)
+    {
+        REQUIRE(assignment == nullptr);
+        REQUIRE(solver.interrupted());
+        REQUIRE(finishTime - cancelTime < seconds(2));
+    }
+}
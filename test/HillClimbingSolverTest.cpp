@@ -0,0 +1,171 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "../src/HillClimbingSolver.h"
+
+#define PREFIX "[HillClimbingSolver] "
+
+TEST_CASE(PREFIX "Guided neighbor keys put the most improving relocation first")
+{
+    // In s1, p2 only gets its second choice c1 and in s2, p1 gets none of its choices. Moving c3 to s2 gives p1 a
+    // first choice there and leaves p2 with c1 in s1, which is the best relocation.
+    //
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++choice("c1", bounds(0, 2));
++choice("c2", bounds(0, 2));
++choice("c3", bounds(0, 2));
++choice("c4", bounds(0, 2));
++chooser("p1", [100, 0, 100, 0]);
++chooser("p2", [50, 100, 0, 100]);
+)");
+
+    auto options = default_options();
+    HillClimbingSolver solver(data, csa(data, false), sd(data), scoring(data, options), options);
+    AssignmentSolver assignmentSolver(data, csa(data, false), sd(data), options);
+
+    auto scheduling = MAKE_SCHED(data, (vector<int> {0, 1, 0, 1}));
+    auto assignment = assignmentSolver.solve(scheduling);
+    auto slotDuals = assignmentSolver.slot_duals(*assignment);
+
+    // The native backend provides dual values; without them, the heuristic fallback is used.
+    //
+    REQUIRE(slotDuals.size() == 2);
+
+    for(auto const& keys : {solver.guided_neighbor_keys(scheduling, assignment, slotDuals),
+                            solver.guided_neighbor_keys(scheduling, assignment)})
+    {
+        // With two slots, the neighbor key of a relocation is the moved choice.
+        //
+        REQUIRE(keys.size() == 4);
+        REQUIRE(keys.front() == 2);
+        REQUIRE((ordered_set<int>(keys.begin(), keys.end()) == ordered_set<int> {0, 1, 2, 3}));
+    }
+}
+
+TEST_CASE(PREFIX "Neighbors move tied choices together and respect slot size limits")
+{
+    // The two parts of c1 (the choices 0 and 1) have an offset of one slot, and c4 and c5 have to be in the same slot.
+    // Only one choice fits into s4, so a move that puts another choice there without taking c3 out is invalid.
+    //
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++slot("s3");
++slot("s4");
++choice("c1", bounds(0, 10), parts(2));
++choice("c2", bounds(0, 10));
++choice("c3", bounds(0, 10));
++choice("c4", bounds(0, 10));
++choice("c5", bounds(0, 10));
++chooser("p1", [100, 0, 0, 0, 0]);
++chooser("p2", [0, 100, 0, 0, 0]);
++constraint(choice("c4").slot == choice("c5").slot);
++constraint(slot("s4").size <= 1);
+)");
+
+    auto options = default_options();
+    options->set_max_neighbors(1000);
+    HillClimbingSolver solver(data, csa(data, false), sd(data), scoring(data, options), options);
+
+    auto scheduling = MAKE_SCHED(data, (vector<int> {0, 1, 2, 3, 2, 2}));
+    auto neighbors = solver.pick_neighbors(scheduling);
+
+    ordered_set<vector<int>> neighborData;
+    for(auto const& neighbor : neighbors)
+    {
+        neighborData.insert(neighbor->raw_data());
+
+        // Tied choices are always moved by the same number of slots.
+        //
+        for(Constraint const& constraint : data->scheduling_constraints())
+        {
+            if(constraint.type() != ChoicesHaveOffset && constraint.type() != ChoicesAreInSameSlot) continue;
+
+            int l = constraint.left();
+            int r = constraint.right();
+            REQUIRE(neighbor->slot_of(l) - scheduling->slot_of(l) == neighbor->slot_of(r) - scheduling->slot_of(r));
+        }
+
+        int s4Size = 0;
+        for(int w = 0; w < data->choice_count(); w++)
+        {
+            if(neighbor->slot_of(w) == 3) s4Size++;
+        }
+
+        REQUIRE(s4Size <= 1);
+    }
+
+    // Moving c2 to s1 is valid, moving it to s4 is not. Both are decided without solving any assignment.
+    //
+    REQUIRE(neighborData.count({0, 1, 0, 3, 2, 2}) == 1);
+    REQUIRE(neighborData.count({0, 1, 3, 3, 2, 2}) == 0);
+    REQUIRE(neighborData.count({0, 1, 2, 3, 0, 0}) == 1);
+    REQUIRE(solver.assignment_count() == 0);
+}
+
+TEST_CASE(PREFIX "Swaps and chains are generated when no relocation is feasible")
+{
+    Rng::seed(20);
+
+    // Every slot needs exactly two choices to seat all four choosers, so every relocation makes one slot too small.
+    //
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++slot("s3");
++choice("c1", bounds(2, 2));
++choice("c2", bounds(2, 2));
++choice("c3", bounds(2, 2));
++choice("c4", bounds(2, 2));
++choice("c5", bounds(2, 2));
++choice("c6", bounds(2, 2));
++chooser("p1", [100, 0, 0, 0, 0, 0]);
++chooser("p2", [0, 100, 0, 0, 0, 0]);
++chooser("p3", [0, 0, 100, 0, 0, 0]);
++chooser("p4", [0, 0, 0, 100, 0, 0]);
+)");
+
+    auto options = default_options();
+    options->set_max_neighbors(1000);
+    HillClimbingSolver solver(data, csa(data, false), sd(data), scoring(data, options), options);
+
+    auto scheduling = MAKE_SCHED(data, (vector<int> {0, 0, 1, 1, 2, 2}));
+    auto neighbors = solver.pick_neighbors(scheduling);
+
+    REQUIRE(!neighbors.empty());
+
+    ordered_set<vector<int>> neighborData;
+    for(auto const& neighbor : neighbors)
+    {
+        REQUIRE(neighbor->raw_data() != scheduling->raw_data());
+        neighborData.insert(neighbor->raw_data());
+
+        vector<int> slotSizes(data->slot_count(), 0);
+        for(int w = 0; w < data->choice_count(); w++)
+        {
+            slotSizes[neighbor->slot_of(w)]++;
+        }
+
+        REQUIRE((slotSizes == vector<int> {2, 2, 2}));
+    }
+
+    // Repeatedly sampled swaps and chains are only returned once.
+    //
+    REQUIRE(neighborData.size() == neighbors.size());
+}
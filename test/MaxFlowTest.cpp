@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "../src/MaxFlow.h"
+
+#define PREFIX "[MaxFlow] "
+
+TEST_CASE(PREFIX "Finds maximum flow")
+{
+    MaxFlow flow(4, 0, 3);
+
+    int e01 = flow.add_edge(0, 1, 2);
+    int e02 = flow.add_edge(0, 2, 1);
+    int e12 = flow.add_edge(1, 2, 1);
+    int e13 = flow.add_edge(1, 3, 1);
+    int e23 = flow.add_edge(2, 3, 2);
+
+    REQUIRE(flow.augment() == 3);
+    REQUIRE(flow.flow(e01) == 2);
+    REQUIRE(flow.flow(e02) == 1);
+    REQUIRE(flow.flow(e12) == 1);
+    REQUIRE(flow.flow(e13) == 1);
+    REQUIRE(flow.flow(e23) == 2);
+}
+
+TEST_CASE(PREFIX "Continues with the existing flow after adding edges")
+{
+    MaxFlow flow(3, 0, 2);
+
+    flow.add_edge(0, 1, 2);
+    REQUIRE(flow.augment() == 0);
+
+    flow.add_edge(1, 2, 1);
+    REQUIRE(flow.augment() == 1);
+
+    flow.add_edge(0, 2, 3);
+    REQUIRE(flow.augment() == 4);
+    REQUIRE(flow.total_flow() == 4);
+}
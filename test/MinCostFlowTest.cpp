@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "../src/MinCostFlow.h"
+
+#define PREFIX "[MinCostFlow] "
+
+TEST_CASE(PREFIX "Finds minimal cost flow")
+{
+    MinCostFlow flow(4);
+    flow.set_supply(0, 2);
+    flow.set_supply(3, -2);
+
+    int e01 = flow.add_edge(0, 1, 1, 1);
+    int e02 = flow.add_edge(0, 2, 2, 5);
+    int e13 = flow.add_edge(1, 3, 2, 1);
+    int e23 = flow.add_edge(2, 3, 2, 1);
+    int e12 = flow.add_edge(1, 2, 1, 0);
+
+    REQUIRE(flow.solve());
+    REQUIRE(flow.total_cost() == 8);
+    REQUIRE(flow.flow(e01) == 1);
+    REQUIRE(flow.flow(e02) == 1);
+    REQUIRE(flow.flow(e13) == 1);
+    REQUIRE(flow.flow(e23) == 1);
+    REQUIRE(flow.flow(e12) == 0);
+}
+
+TEST_CASE(PREFIX "Detects infeasible instances")
+{
+    MinCostFlow flow(3);
+    flow.set_supply(0, 2);
+    flow.set_supply(2, -2);
+
+    flow.add_edge(0, 1, 2, 1);
+    flow.add_edge(1, 2, 1, 1);
+
+    REQUIRE_FALSE(flow.solve());
+
+    MinCostFlow unbalanced(2);
+    unbalanced.set_supply(0, 2);
+    unbalanced.set_supply(1, -1);
+    unbalanced.add_edge(0, 1, 5, 1);
+
+    REQUIRE_FALSE(unbalanced.solve());
+}
+
+TEST_CASE(PREFIX "Can be solved repeatedly")
+{
+    MinCostFlow flow(3);
+    flow.set_supply(0, 1);
+    flow.set_supply(2, -1);
+
+    flow.add_edge(0, 2, 1, 10);
+    REQUIRE(flow.solve());
+    REQUIRE(flow.total_cost() == 10);
+
+    flow.add_edge(0, 1, 1, 1);
+    flow.add_edge(1, 2, 1, 1);
+    REQUIRE(flow.solve());
+    REQUIRE(flow.total_cost() == 2);
+}
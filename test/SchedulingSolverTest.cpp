@@ -474,4 +474,157 @@ var p = [1, 1, 1, 1, 1];
 
         REQUIRE(s1 >= 3);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE(PREFIX "Combined constraints work")
+{
+    Rng::seed(12);
+
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++slot("s3");
++choice("c1", bounds(2, 2));
++choice("c2", bounds(2, 2));
++choice("c3", bounds(2, 2));
++choice("c4", bounds(2, 2));
++choice("c5", bounds(2, 2));
++choice("c6", bounds(2, 2));
+
+var p = [1, 1, 1, 1, 1, 1];
++chooser("p1", p);
++chooser("p2", p);
++chooser("p3", p);
++chooser("p4", p);
+
++constraint(choice("c1").slot != choice("c2").slot);
++constraint(choice("c2").slot != choice("c3").slot);
++constraint(choice("c1").slot != choice("c3").slot);
++constraint(choice("c4").slot == choice("c1").slot);
++constraint(choice("c5").slot != choice("c2").slot);
+)");
+
+    SchedulingSolver solver(data, csa(data, false), default_options());
+
+    for(int i = 0; i < 16; i++)
+    {
+        REQUIRE(solver.next_scheduling());
+        auto scheduling = solver.scheduling();
+
+        REQUIRE(scheduling->slot_of(0) != scheduling->slot_of(1));
+        REQUIRE(scheduling->slot_of(1) != scheduling->slot_of(2));
+        REQUIRE(scheduling->slot_of(0) != scheduling->slot_of(2));
+        REQUIRE(scheduling->slot_of(3) == scheduling->slot_of(0));
+        REQUIRE(scheduling->slot_of(4) != scheduling->slot_of(1));
+    }
+}
+
+TEST_CASE(PREFIX "Infeasible constraints are detected repeatedly")
+{
+    Rng::seed(12);
+
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++choice("c1", bounds(2, 2));
++choice("c2", bounds(2, 2));
++choice("c3", bounds(2, 2));
++choice("c4", bounds(2, 2));
+
+var p = [1, 1, 1, 1];
++chooser("p1", p);
++chooser("p2", p);
++chooser("p3", p);
++chooser("p4", p);
+
++constraint(choice("c1").slot != choice("c2").slot);
++constraint(choice("c2").slot != choice("c3").slot);
++constraint(choice("c1").slot != choice("c3").slot);
+)");
+
+    SchedulingSolver solver(data, csa(data, false), default_options());
+
+    REQUIRE(!solver.next_scheduling());
+    int searchCount = solver.search_count();
+    REQUIRE(searchCount > 0);
+
+    // The first call proved that there is no scheduling, so the second one does not search again.
+    //
+    REQUIRE(!solver.next_scheduling());
+    REQUIRE(solver.search_count() == searchCount);
+    REQUIRE(!solver.has_solution());
+}
+
+TEST_CASE(PREFIX "Backjumping skips decisions that are not responsible for a failure")
+{
+    Rng::seed(12);
+
+    // The fixed choices are decided first, c1 and c2 before c3 since they have more constraints. Then c4 fits neither
+    // into s1 nor s2 because of c1 and c2 alone, so the search jumps back over the decision of c3.
+    //
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++slot("s3");
++choice("c1", bounds(3, 4));
++choice("c2", bounds(3, 4));
++choice("c3", bounds(0, 4));
++choice("c4", bounds(2, 4));
++choice("c5", bounds(0, 4));
+
+var p = [1, 1, 1, 1, 1];
++chooser("p1", p);
++chooser("p2", p);
++chooser("p3", p);
++chooser("p4", p);
+
++constraint(choice("c1").slot == slot("s1"));
++constraint(choice("c2").slot == slot("s2"));
++constraint(choice("c1").slot != choice("c2").slot);
++constraint(choice("c3").slot == slot("s3"));
++constraint(choice("c4").slot != slot("s3"));
+)");
+
+    SchedulingSolver solver(data, csa(data, false), default_options());
+
+    REQUIRE(!solver.next_scheduling());
+    REQUIRE(solver.skipped_level_count() > 0);
+}
+
+TEST_CASE(PREFIX "Nogoods learned in one search prune the next search")
+{
+    Rng::seed(12);
+
+    // c1 and c3 are fixed and decided first, then c2 (which has the smaller domain) tries the emptier slot s2 first.
+    // This leaves no slot for c4, and the learned nogood excludes s2 for c2 right away in the next search.
+    //
+    auto data = parse_data(R"(
++slot("s1");
++slot("s2");
++slot("s3");
++choice("c1", bounds(3, 4));
++choice("c2", bounds(0, 4));
++choice("c3", bounds(3, 4));
++choice("c4", bounds(2, 4));
+
+var p = [0, 0, 0, 0];
++chooser("p1", p);
++chooser("p2", p);
++chooser("p3", p);
++chooser("p4", p);
+
++constraint(choice("c1").slot == slot("s1"));
++constraint(choice("c3").slot == slot("s3"));
++constraint(choice("c2").slot != choice("c1").slot);
++constraint(choice("c2").slot != choice("c4").slot);
+)");
+
+    SchedulingSolver solver(data, csa(data, false), default_options());
+
+    REQUIRE(solver.next_scheduling());
+    REQUIRE(solver.nogood_prune_count() == 0);
+
+    REQUIRE(solver.next_scheduling());
+    REQUIRE(solver.nogood_prune_count() > 0);
+    REQUIRE(solver.scheduling()->slot_of(1) == 2);
+}
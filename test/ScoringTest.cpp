@@ -0,0 +1,40 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+#include "inputs/two_slots.h"
+#include "../src/AssignmentSolver.h"
+
+#define PREFIX "[Scoring] "
+
+TEST_CASE(PREFIX "Score lower bound does not exceed the score of the optimal assignment")
+{
+    auto data = parse_data(INPUT_TWO_SLOTS + R"(
++constraint(chooser("p1").choices.contains_not(choice("c3")));
+)");
+
+    auto options = default_options();
+    AssignmentSolver solver(data, csa(data, false), sd(data), options);
+
+    for(auto const& raw : vector<vector<int>> {{0, 0, 1, 1}, {0, 1, 1, 0}, {0, 1, 0, 1}})
+    {
+        auto scheduling = MAKE_SCHED(data, raw);
+        auto score = scoring(data, options)->evaluate(sol(scheduling, solver.solve(scheduling)));
+        auto bound = scoring(data, options)->lower_bound(*scheduling);
+
+        REQUIRE_FALSE(score < bound);
+    }
+}
@@ -16,6 +16,7 @@
 
 #include "common.h"
 #include "inputs/minimal.h"
+#include "inputs/two_slots.h"
 #include "../src/ShotgunSolver.h"
 #include "../src/Status.h"
 #include "../src/ShotgunSolverThreaded.h"
@@ -28,4 +29,21 @@ TEST_CASE(PREFIX "Minimal")
     auto solution = solve(data);
     expect_assignment(solution, "p,e");
     expect_scheduling(solution, "e,s");
-}
\ No newline at end of file
+}
+
+TEST_CASE(PREFIX "Guided neighbors find the optimal scheduling")
+{
+    auto data = parse_data(INPUT_TWO_SLOTS);
+    auto options = default_options();
+    options->set_timeout_seconds(1);
+    options->set_guided_neighbors(true);
+
+    ShotgunSolverThreaded solver(data, csa(data), sd(data), scoring(data, options), options);
+    solver.start();
+
+    // Every chooser can get a first choice in both slots.
+    //
+    auto solution = solver.wait_for_result();
+    REQUIRE(scoring(data, options)->is_feasible(solution));
+    REQUIRE(scoring(data, options)->evaluate(solution).major == 0);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common.h"
+
+#include "../src/ThreadBudget.h"
+
+#define PREFIX "[ThreadBudget] "
+
+TEST_CASE(PREFIX "Initially, all outer threads are active")
+{
+    ThreadBudget budget(8, 4);
+
+    REQUIRE(budget.outer_threads() == 4);
+    REQUIRE(budget.inner_threads() == 2);
+    REQUIRE(budget.is_active(3));
+    REQUIRE(!budget.is_active(4));
+}
+
+TEST_CASE(PREFIX "Slow solves shift threads inward and fast solves back outward")
+{
+    ThreadBudget budget(8, 4);
+
+    for(int i = 0; i < 64; i++) budget.report_solve(seconds(1));
+
+    REQUIRE(budget.outer_threads() == 2);
+    REQUIRE(budget.inner_threads() == 4);
+    REQUIRE(!budget.is_active(2));
+
+    for(int i = 0; i < 64; i++) budget.report_solve(milliseconds(1));
+
+    REQUIRE(budget.outer_threads() == 4);
+    REQUIRE(budget.inner_threads() == 2);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2020 Maximilian Azendorf
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <string>
+
+/**
+ * Two slots with four choices and four choosers of two different kinds. Tests append the constraints they need.
+ */
+inline const std::string INPUT_TWO_SLOTS = R"(
++slot("s1");
++slot("s2");
++choice("c1", bounds(1, 2));
++choice("c2", bounds(1, 2));
++choice("c3", bounds(1, 2));
++choice("c4", bounds(1, 2));
++chooser("p1", [100, 0, 100, 50]);
++chooser("p2", [100, 0, 100, 50]);
++chooser("p3", [0, 100, 50, 100]);
++chooser("p4", [0, 100, 70, 100]);
+)";